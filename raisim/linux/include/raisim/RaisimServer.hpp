@@ -18,6 +18,8 @@
 #include <unistd.h>
 #include <errno.h>
 #include <poll.h>
+#include <limits.h>
+#include <sys/uio.h>
 #elif WIN32
 #undef UNICODE
 #define WIN32_LEAN_AND_MEAN
@@ -28,6 +30,7 @@
 #endif
 
 #if __linux__
+#include <sys/epoll.h>
 #define RAISIM_SERVER_SOCKET_OPTION SO_REUSEADDR | SO_REUSEPORT
 #elif __APPLE__
 #define RAISIM_SERVER_SOCKET_OPTION SO_REUSEPORT
@@ -44,10 +47,16 @@
 #include <future>
 #include <chrono>
 #include <queue>
+#include <memory>
+#include <map>
+#include <unordered_map>
 #include "raisim/server/Visuals.hpp"
 #include "raisim/server/Charts.hpp"
 #include "raisim/server/SerializationHelper.hpp"
+#include "raisim/server/FrameCompression.hpp"
+#include "raisim/server/SharedMemoryTransport.hpp"
 #include "raisim/World.hpp"
+#include "raisim/SolverProfiler.hpp"
 #include "raisim/helper.hpp"
 #include "raisim/object/ArticulatedSystem/JointAndBodies.hpp"
 #include "raisim/sensors/Sensors.hpp"
@@ -56,9 +65,29 @@ namespace raisim {
 
 class RaisimServer final {
  public:
-  static constexpr int SEND_BUFFER_SIZE = 33554432;
   static constexpr int MAXIMUM_PACKET_SIZE = 32384;
   static constexpr int RECEIVE_BUFFER_SIZE = 33554432;
+  static constexpr int SNAPSHOT_TIMEOUT_US = 100000;
+  static constexpr int CLIENT_TIMEOUT_S = 10;
+  static constexpr int VERSION_MASK = 0xffff;
+
+  /// capabilities of the client. They are sent in the upper bits of the client version
+  enum Capability : int {
+    /// the client can decompress frames. A compressed frame is marked with this bit in its version field
+    CAPABILITY_ZLIB = 1 << 16,
+    /// the client can read quantized poses and heights (ServerMessageType::QUANTIZED)
+    CAPABILITY_QUANTIZED = 1 << 17,
+    /// the client can patch the changed rectangles of a heightmap (see getHeightMapRegions)
+    CAPABILITY_HEIGHTMAP_REGIONS = 1 << 18
+  };
+
+  /// how the frames are delivered to the clients
+  enum class Transport : int {
+    /// a TCP socket. The client requests each frame
+    TCP = 0,
+    /// a shared-memory ring (server::SharedMemoryRingWriter) for clients on the same host. See launchServer
+    SHARED_MEMORY
+  };
 
   enum ClientMessageType : int {
     REQUEST_UPDATE = 0,
@@ -67,7 +96,13 @@ class RaisimServer final {
 
   enum ServerMessageType : int {
     UPDATE_ALL = 0,
-    No_MESSAGE
+    No_MESSAGE,
+    UPDATE_DELTA,
+    /// flag combined with UPDATE_ALL or UPDATE_DELTA. Poses and heights are quantized (see setQuantization)
+    QUANTIZED = 1 << 8,
+    /// flag combined with UPDATE_DELTA. The frame contains all objects. A client removes the objects that are not in a
+    /// keyframe, so that it recovers from skipped frames (e.g., with removed objects)
+    KEYFRAME = 1 << 9
   };
 
   enum class ServerRequestType : int {
@@ -118,7 +153,7 @@ class RaisimServer final {
    * create a raisimSever for a world. */
   explicit RaisimServer(World *world) : world_(world) {
     receive_buffer.resize(RECEIVE_BUFFER_SIZE);
-    send_buffer.resize(SEND_BUFFER_SIZE);
+    send_buffer.resize(MAXIMUM_PACKET_SIZE);
     memset(tempBuffer, 0, MAXIMUM_PACKET_SIZE * sizeof(char));
   }
 
@@ -147,7 +182,7 @@ class RaisimServer final {
 
     // Forcefully attaching socket to the port 8080
     RSFATAL_IF(bind(server_fd_, (struct sockaddr *) &address, sizeof(address)) < 0, "bind error, errno: " << errno)
-    RSFATAL_IF(listen(server_fd_, 3) < 0, "listen error, errno: " << errno)
+    RSFATAL_IF(listen(server_fd_, std::max(3, maxClients_)) < 0, "listen error, errno: " << errno)
 
 #elif WIN32
     WSADATA wsaData;
@@ -255,12 +290,33 @@ class RaisimServer final {
     for (auto& ob: instancedvisuals_) ob.second->visualTag = 0u;
     for (auto& ob: polyLines_) ob.second->visualTag = 0u;
     for (auto& ob: charts_) ob.second->visualTag = 0u;
+    objectIndex_.invalidate();
+    sentState_.clear();
+    framesSinceKeyframe_ = 0;
+    publishedSnapshot_.store(nullptr);
+    {
+      std::lock_guard<std::mutex> guard(deferredRequestMutex_);
+      deferredRequests_.clear();
+    }
     unlockVisualizationServerMutex();
   }
 
   inline void loop(int port = 8080) {
+#if __linux__ || __APPLE__
+    if (transport_ == Transport::SHARED_MEMORY) {
+      runSharedMemoryLoop(port);
+      state_ = STATUS_RENDERING;
+      return;
+    }
+#endif
+
     setupSocket(port);
 
+#if __linux__
+    if (maxClients_ > 1 || pipelining_)
+      runEventLoop();
+#endif
+
     while (!terminateRequested_) {
       acceptConnection(100000);
 
@@ -291,10 +347,118 @@ class RaisimServer final {
     mapName_ = map;
   }
 
+  /**
+   * @param[in] enable if true, the server sends only the objects whose state changed since they were last sent
+   * @param[in] epsilon changes of the pose (and of the generalized coordinate) smaller than this value are ignored
+   * @param[in] keyframeInterval every keyframeInterval-th frame contains all objects
+   * Delta encoding is an extension of the protocol. The frames are sent as ServerMessageType::UPDATE_DELTA,
+   * which contains only the changed objects followed by the visual tags of the removed objects. The removed objects are
+   * listed only once. Keyframes are UPDATE_DELTA | KEYFRAME. A client that skipped frames drops the objects that are
+   * not in the next keyframe.
+   * Only enable it if the visualizer understands this message type. */
+  inline void setDeltaEncoding(bool enable, double epsilon = 1e-5, int keyframeInterval = 100) {
+    lockVisualizationServerMutex();
+    deltaEncoding_ = enable;
+    deltaEpsilon_ = epsilon;
+    keyframeInterval_ = std::max(keyframeInterval, 1);
+    sentState_.clear();
+    framesSinceKeyframe_ = 0;
+    unlockVisualizationServerMutex();
+  }
+
+  /**
+   * @param[in] level zlib compression level (1: fastest, 9: smallest). 0 disables the compression
+   * @param[in] threshold frames smaller than this (in bytes) are not compressed
+   * Frames are compressed only for clients that set CAPABILITY_ZLIB in their version.
+   * A compressed frame is [size][version | CAPABILITY_ZLIB][uncompressed size][zlib stream], where the stream
+   * contains the rest of the frame after the version field.
+   * The server thread applies the new level before it compresses the next frame. */
+  inline void setCompression(int level, int threshold = 65536) {
+    lockVisualizationServerMutex();
+    compressionLevel_ = level;
+    compressionThreshold_ = size_t(std::max(threshold, 0));
+    unlockVisualizationServerMutex();
+  }
+
+  /**
+   * @param[in] enable if true, the poses and the heights are quantized for clients that set CAPABILITY_QUANTIZED
+   * @param[in] positionResolution the resolution of the positions in meters
+   * A quantized frame has the type (UPDATE_ALL or UPDATE_DELTA) | QUANTIZED, followed by the origin (3 doubles) and the
+   * resolution (double). A position is 3 int32 relative to the origin, an orientation is a smallest-three
+   * quaternion in 32 bits (server::setQuantized) and heights are 16-bit samples with an offset and a scale
+   * (server::setQuantizedHeights). In the multi-client mode, all clients must support it. */
+  inline void setQuantization(bool enable, double positionResolution = 1e-3) {
+    lockVisualizationServerMutex();
+    quantization_ = enable;
+    positionResolution_ = positionResolution;
+    unlockVisualizationServerMutex();
+  }
+
+  /**
+   * @param[in] enable if true, the world is serialized into a pre-allocated snapshot buffer right after it is integrated
+   * in integrateWorldThreadSafe. The server thread streams the latest snapshot without locking the world, so that a slow
+   * client does not stall the simulation. The requests from the client are applied before the next integration.
+   * If the world is not integrated for a while, the server thread serializes the world by itself. */
+  inline void setSnapshotMode(bool enable) {
+    lockVisualizationServerMutex();
+    snapshotMode_ = enable;
+    publishedSnapshot_.store(nullptr);
+    unlockVisualizationServerMutex();
+  }
+
+  /**
+   * @param[in] maxClients the maximum number of clients (e.g., a viewer and a recorder) that are served at the same time
+   * If it is larger than 1, the server serializes each frame once and sends the same buffer to all clients that
+   * requested a frame. A slow client does not stall the others. It skips the frames produced while it was busy.
+   * A new connection reinitializes the scene of all clients. Only the first connected client updates the sensors
+   * rendered by the visualizer. Dragging objects works reliably only from this client.
+   * Multiple clients are supported on Linux only. Call this method before launchServer. */
+  inline void setMaximumNumberOfClients(int maxClients) {
+#if __linux__
+    maxClients_ = std::max(maxClients, 1);
+#else
+    RSWARN_IF(maxClients > 1, "Multiple clients are supported on Linux only")
+#endif
+  }
+
+  /**
+   * @param[in] enable if true, the server runs an event loop on non-blocking sockets (as with multiple clients) and
+   * serializes the next frame while the current one is in flight, so that a request is answered without waiting for
+   * the serialization. A client may also send several requests without waiting for the frames. They are answered in
+   * order. The frames are therefore up to one frame older and the client requests take effect one frame later.
+   * Pipelining is supported on Linux only. Call this method before launchServer. */
+  inline void setPipelining(bool enable) {
+#if __linux__
+    pipelining_ = enable;
+#else
+    RSWARN_IF(enable, "Pipelining is supported on Linux only")
+#endif
+  }
+
+  /**
+   * @param[in] slotCount the number of frames kept in the shared-memory ring
+   * @param[in] slotCapacity the maximum size of a frame in bytes. Larger frames are not published
+   * @param[in] permissions the permission bits of the shared memory object. The default (0600) gives access to the
+   * user of the server only. A reader needs read and write access
+   * Call this method before launchServer. */
+  inline void setSharedMemoryRing(int slotCount, size_t slotCapacity, int permissions = 0600) {
+    sharedMemorySlots_ = std::max(slotCount, 2);
+    sharedMemorySlotCapacity_ = slotCapacity;
+    sharedMemoryPermissions_ = permissions;
+  }
+
   /**
    * @param[in] port port number to stream
+   * @param[in] transport Transport::SHARED_MEMORY publishes the frames into the shared memory object
+   * server::sharedMemoryName(port) instead of opening the port. The server publishes a frame whenever the world time
+   * changes and never waits for the readers (see server::SharedMemoryRingReader). The readers cannot send requests and
+   * the sensors rendered by the visualizer are not updated. The shared-memory transport is not available on Windows.
    * start spinning. */
-  inline void launchServer(int port = 8080) {
+  inline void launchServer(int port = 8080, Transport transport = Transport::TCP) {
+#if WIN32
+    RSFATAL_IF(transport == Transport::SHARED_MEMORY, "The shared-memory transport is not available on Windows")
+#endif
+    transport_ = transport;
     raisimPort_ = port;
     tryingToLock_ = false;
 
@@ -310,13 +474,29 @@ class RaisimServer final {
    * Integrate the world. */
   inline void integrateWorldThreadSafe() {
     lockVisualizationServerMutex();
+    if (snapshotMode_) applyDeferredClientRequests();
     applyInteractionForce();
     world_->integrate();
+    if (snapshotMode_ && connected_ && state_ != STATUS_HIBERNATING &&
+        !publishedSnapshot_.load(std::memory_order_acquire))
+      publishSnapshot();
     unlockVisualizationServerMutex();
     if (tryingToLock_)
       USLEEP(10);
   }
 
+  /**
+   * @param[in] name name of the object
+   * @return the object or nullptr. Unlike World::getObject, it uses a hash index maintained by the server.
+   * It locks the visualization mutex, so do not call it while holding the mutex. */
+  inline Object *findObject(const std::string &name) {
+    lockVisualizationServerMutex();
+    objectIndex_.refresh(world_, visTagCounter);
+    auto ob = objectIndex_.findByName(name);
+    unlockVisualizationServerMutex();
+    return ob;
+  }
+
   /**
    * Apply interaction force, which is specified by the user in the visualizer (raisimUnreal).
    * This is automatically called in raisim::RaisimServer::integrateWorldThreadSafe. */
@@ -324,12 +504,11 @@ class RaisimServer final {
     // interaction wire
     if (wireStiffness_ > 0 && hangingObjVisTag_ != 0) {
       Vec<3> normal, vel, force;
-      auto iter = std::find_if(world_->getObjList().begin(), world_->getObjList().end(),
-                               [&](const Object *o) { return o->visualTag == hangingObjVisTag_; });
-      if (iter == world_->getObjList().end()) {
+      auto ob = findObjectByVisualTag(hangingObjVisTag_);
+      if (!ob) {
         hangingObjLocalId_ = -1;
       } else {
-        interactingOb_ = *iter;
+        interactingOb_ = ob;
         interactingOb_->getPosition(hangingObjLocalId_, hangingObjLocalPos_, hangingObjPos_);
         interactingOb_->getVelocity(hangingObjLocalId_, hangingObjLocalPos_, vel);
         vecsub(hangingObjTargetPos_, hangingObjPos_, normal);
@@ -338,11 +517,7 @@ class RaisimServer final {
           normal *= 1. / distance;
           double axisVel = vecDot(vel, normal);
           force = wireStiffness_ * (distance - 0.5 * axisVel * world_->getTimeStep()) * normal * interactingOb_->getMass(hangingObjLocalId_);
-
-          if (std::find(world_->getObjList().begin(), world_->getObjList().end(), interactingOb_)
-              != world_->getObjList().end()) {
-            interactingOb_->setConstraintForce(hangingObjLocalId_, hangingObjLocalPos_, force);
-          }
+          interactingOb_->setConstraintForce(hangingObjLocalId_, hangingObjLocalPos_, force);
         }
       }
     } else {
@@ -883,6 +1058,19 @@ class RaisimServer final {
     return visualHm_[name];
   }
 
+  /**
+   * @param[in] hm a heightmap of the world or of a visual heightmap
+   * @return the regions to be passed to HeightMap::updateRegion, so that only the changed rectangles are sent.
+   * The update of a heightmap is then [2][rectangle count]{[x0][y0][width][height][heights]} instead of
+   * [1][all heights], where the heights of a rectangle are written like the heights of the heightmap, row by row.
+   * The rectangles are sent only to a single TCP client that sets CAPABILITY_HEIGHTMAP_REGIONS, without snapshot mode
+   * and pipelining, because a skipped frame would lose them. Otherwise, the heightmap is marked as updated and all
+   * heights are sent. The regions are removed with the heightmap. Call it and HeightMap::updateRegion while the server
+   * is locked (e.g., lockVisualizationServerMutex) */
+  inline HeightMapRegions *getHeightMapRegions(HeightMap *hm) {
+    return &heightMapRegions_[hm];
+  }
+
   /**
    * @param[in] name the name of the polyline to be removed
    * remove an existing polyline */
@@ -918,6 +1106,7 @@ class RaisimServer final {
    * @param[in] videoName name of the video file to be saved. The videoName must be a valid file name (e.g., no spaces, ending in .mp4)
    * start recording video. RaisimUnity only supports video recording in linux */
   inline void startRecordingVideo(const std::string &videoName) {
+    std::lock_guard<std::mutex> guard(serverRequestMutex_);
     serverRequest_.push_back(ServerRequestType::START_RECORD_VIDEO);
     videoName_ = videoName;
   }
@@ -925,6 +1114,7 @@ class RaisimServer final {
   /**
    * stop recording video */
   inline void stopRecordingVideo() {
+    std::lock_guard<std::mutex> guard(serverRequestMutex_);
     serverRequest_.push_back(ServerRequestType::STOP_RECORD_VIDEO);
   }
 
@@ -936,6 +1126,7 @@ class RaisimServer final {
    * @param[in] lookAt the forward direction of the camera (the up direction is always z-axis)
    * set the camera to a specified position */
   void setCameraPositionAndLookAt(const Eigen::Vector3d &pos, const Eigen::Vector3d &lookAt) {
+    std::lock_guard<std::mutex> guard(serverRequestMutex_);
     serverRequest_.push_back(ServerRequestType::SET_CAMERA_TO);
     position_ = pos;
     lookAt_ = lookAt;
@@ -946,6 +1137,7 @@ class RaisimServer final {
    * move the camera to look at the specified object */
   void focusOn(raisim::Object *obj) {
     RSFATAL_IF(obj == nullptr, "object does not exist.")
+    std::lock_guard<std::mutex> guard(serverRequestMutex_);
     serverRequest_.push_back(ServerRequestType::FOCUS_ON_SPECIFIC_OBJECT);
     toBeFocused_ = obj;
   }
@@ -1067,14 +1259,23 @@ class RaisimServer final {
     if (!receiveData(10)) return false;
 
     int clientVersion;
+    uint32_t objectId;
     rData_ = get(rData_, &clientVersion);
-    rData_ = get(rData_, &type, &objectId_);
+    rData_ = get(rData_, &type, &objectId);
+    objectId_ = objectId;
+    clientCapabilities_ = clientVersion & ~VERSION_MASK;
+    frameCapabilities_ = clientCapabilities_;
+    clientVersion &= VERSION_MASK;
+
+    if (snapshotMode_ && clientVersion == version_)
+      return processRequestsWithSnapshot();
 
     data_ = set(&send_buffer[0] + sizeof(int), version_);
+    char *headerEnd;
+    const server::SegmentedBuffer *body = nullptr;
     if (clientVersion == version_) {
       // get client request
       int clientRequestSize;
-      ClientRequestType requestType;
       rData_ = get(rData_, &clientRequestSize);
       wireStiffness_ = 0.;
       tryingToLock_ = true;
@@ -1082,189 +1283,21 @@ class RaisimServer final {
       lockVisualizationServerMutex();
       tryingToLock_ = false;
 
-      for (int i=0; i<clientRequestSize; i++) {
-        rData_ = get(rData_, &requestType);
-        switch (requestType) {
-          case ClientRequestType::CR_ATTACH_WIRE: {
-            rData_ = get(rData_, &hangingObjVisTag_, &hangingObjLocalId_, &hangingObjPos_);
-
-            // hanging rope
-            auto &obList = world_->getObjList();
-            auto iter = std::find_if(obList.begin(), obList.end(),
-                                     [&](const Object *o) { return o->visualTag == hangingObjVisTag_; });
-            if (iter != obList.end()) {
-              interactingOb_ = *iter;
-              interactingOb_->lockMutex();
-              if (interactingOb_->getObjectType() == ObjectType::ARTICULATED_SYSTEM) {
-                auto as = dynamic_cast<ArticulatedSystem *>(interactingOb_);
-                as->getPositionInBodyCoordinate(hangingObjLocalId_, hangingObjPos_, hangingObjLocalPos_);
-              } else {
-                auto sob = dynamic_cast<SingleBodyObject *>(interactingOb_);
-                Vec<3> sobPos;
-                Mat<3, 3> sobRot;
-                sob->getPosition(sobPos);
-                sob->getOrientation(0, sobRot);
-                hangingObjLocalPos_ = sobRot.transpose() * (hangingObjPos_ - sobPos);
-              }
-              interactingOb_->unlockMutex();
-            } else {
-              hangingObjLocalId_ = -1;
-            }
-          }
-            break;
-          case ClientRequestType::CR_DRAG_OBJECT: {
-            rData_ = getInFloat(rData_, &wireStiffness_);
-            rData_ = get(rData_, &hangingObjTargetPos_);
-          }
-            break;
-
-          case ClientRequestType::CR_REMOVE_OBJECT: {
-            uint32_t id;
-            rData_ = get(rData_, &id);
-            auto &obList = world_->getObjList();
-            auto iter = std::find_if(obList.begin(), obList.end(),
-                                     [&](const Object *o) { return o->visualTag == id; });
-            if (iter != obList.end()) {
-              auto ob = *iter;
-              world_->removeObject(ob);
-            } else {
-              auto &wireList = world_->getWires();
-              LengthConstraint *w = nullptr;
-              for (int j = 0; j < wireList.size(); j++) {
-                if (wireList[j]->visualTag == id) {
-                  w = wireList[j].get();
-                  break;
-                }
-              }
-              if (w)
-                world_->removeObject(w);
-            }
-          }
-            break;
-          case ClientRequestType::CR_SPAWN_BOX:
-          case ClientRequestType::CR_SPAWN_SPHERE:
-          case ClientRequestType::CR_SPAWN_CYLINDER:
-          case ClientRequestType::CR_SPAWN_CAPSULE:
-          case ClientRequestType::CR_SPAWN_HEIGHT_MAP:
-          case ClientRequestType::CR_SPAWN_MESH:
-          case ClientRequestType::CR_SPAWN_PLANE:
-          case ClientRequestType::CR_SPAWN_AS: {
-            std::string name, appearance, file;
-            float mass;
-            int bodyType;
-            Vec<3> pos, linVel, angVel;
-            Vec<6> size;
-            Vec<4> quat;
-            rData_ = get(rData_, &name, &appearance, &mass);
-            rData_ = getInFloat(rData_, &size, &pos, &linVel, &angVel, &quat);
-            rData_ = get(rData_, &bodyType, &file);
-
-            if (requestType == ClientRequestType::CR_SPAWN_HEIGHT_MAP ||
-                requestType == ClientRequestType::CR_SPAWN_MESH ||
-                requestType == ClientRequestType::CR_SPAWN_AS) {
-              if (!raisim::fileExists(file)) {
-                RSWARN("file \""<<file<<"\" does not exist. Ignoring the spawning commnad.")
-                continue;
-              }
-            }
-
-            if (int(requestType) < 4 || requestType == ClientRequestType::CR_SPAWN_MESH) {
-              raisim::SingleBodyObject* sob = nullptr;
-
-              if (requestType == ClientRequestType::CR_SPAWN_BOX) {
-                sob = world_->addBox(size[0], size[1], size[2], mass);
-              } else if (requestType == ClientRequestType::CR_SPAWN_SPHERE) {
-                sob = world_->addSphere(size[0], mass);
-              } else if (requestType == ClientRequestType::CR_SPAWN_CYLINDER) {
-                sob = world_->addCylinder(size[0], size[1], mass);
-              } else if (requestType == ClientRequestType::CR_SPAWN_CAPSULE) {
-                sob = world_->addCapsule(size[0], size[1], mass);
-              } else if (requestType == ClientRequestType::CR_SPAWN_MESH) {
-                sob = world_->addMesh(file, mass);
-              }
-
-              if (sob) {
-                sob->setPosition(pos);
-                sob->setOrientation(quat);
-                sob->setLinearVelocity(linVel);
-                sob->setAngularVelocity(angVel);
-                sob->setName(name);
-                sob->setAppearance(appearance);
-                if (bodyType == 0) {
-                  sob->setBodyType(BodyType::DYNAMIC);
-                } else if (bodyType == 1) {
-                  sob->setBodyType(BodyType::KINEMATIC);
-                } else if (bodyType == 2) {
-                  sob->setBodyType(BodyType::STATIC);
-                } else {
-                  RSFATAL("Unknown body!")
-                }
-              }
-            } else if (requestType == ClientRequestType::CR_SPAWN_PLANE) {
-              auto ground = world_->addGround(size[0]);
-              ground->setName(name);
-            } else if (requestType == ClientRequestType::CR_SPAWN_HEIGHT_MAP) {
-              auto hm = world_->addHeightMap(file, size[0], size[1], size[2], size[3], size[4], size[5]);
-              hm->setName(name);
-            } else if (requestType == ClientRequestType::CR_SPAWN_AS) {
-              auto as = world_->addArticulatedSystem(file);
-              as->setName(name);
-              as->setBasePos(pos);
-              as->setBaseOrientation(quat);
-            }
-          }
-            break;
-
-          case ClientRequestType::CR_SAVE_THE_WORLD: {
-            std::string path;
-            rData_ = get(rData_, &path);
-            world_->exportToXml(path);
-          }
-            break;
-          default:
-            break;
-        }
-      }
+      rData_ = handleClientRequests(rData_, clientRequestSize);
 
       // set server request
       char* toBeFocusedPtr = nullptr;
-      data_ = set(data_, state_);
-      data_ = set(data_, (int32_t) serverRequest_.size());
-      for (const auto &sr: serverRequest_) {
-        data_ = set(data_, (int) sr);
-
-        switch (sr) {
-          case ServerRequestType::NO_REQUEST:
-          case ServerRequestType::STOP_RECORD_VIDEO:
-          case ServerRequestType::GET_SCREEN_SHOT:
-            break;
-
-          case ServerRequestType::START_RECORD_VIDEO:
-            data_ = set(data_, videoName_);
-            break;
-
-          case ServerRequestType::SET_CAMERA_TO:
-            data_ = set(data_, position_, lookAt_);
-            break;
-
-          case ServerRequestType::FOCUS_ON_SPECIFIC_OBJECT:
-            toBeFocusedPtr = data_;
-            data_ = set(data_, toBeFocused_->visualTag);
-            break;
+      Object* toBeFocused = nullptr;
+      headerEnd = serializeServerRequests(data_, &toBeFocusedPtr, &toBeFocused);
 
-          case ServerRequestType::SET_SCREEN_SIZE:
-            data_ = set(data_, screenShotWidth_, screenShotHeight_);
-            break;
-        }
+      if (state_ != Status::STATUS_HIBERNATING) {
+        update(output_);
+        body = &output_;
       }
 
-      serverRequest_.clear();
-
-      if (state_ != Status::STATUS_HIBERNATING) update();
-
       /// reassign the vis tag because it was reset in the update
       if (toBeFocusedPtr)
-        set(toBeFocusedPtr, toBeFocused_->visualTag);
+        set(toBeFocusedPtr, toBeFocused->visualTag);
 
       unlockVisualizationServerMutex();
 //      auto timeEnd = std::chrono::system_clock::now();
@@ -1275,18 +1308,12 @@ class RaisimServer final {
       return false;
     }
 
-    if (!sendData())
+    if (!sendData(headerEnd, body))
       return false;
 
     if (needsSensorUpdate_) {
-      if (!receiveData(5))
+      if (!receiveSensorMeasurements(sensorUpdateTime_))
         return false;
-
-      /// send dummy data to let visualizer know that receive is done
-      data_ = set(&send_buffer[0] + sizeof(int), version_);
-      sendData();
-
-      updateSensorMeasurements();
       needsSensorUpdate_ = false;
     }
 
@@ -1312,13 +1339,878 @@ class RaisimServer final {
    * Saves the screenshot (the directory is chosen by the visualizer)
    */
   void requestSaveScreenshot() {
-    lockVisualizationServerMutex();
+    std::lock_guard<std::mutex> guard(serverRequestMutex_);
     serverRequest_.push_back(ServerRequestType::GET_SCREEN_SHOT);
-    unlockVisualizationServerMutex();
   }
 
  private:
 
+  /**
+   * Hash index of the objects of a world by visual tag and by name, and of the sensors of the articulated systems by
+   * their full names. The index is rebuilt lazily when the configuration number of the world changes (an object was
+   * added or removed), when new visual tags were assigned or after invalidate() (e.g., the visual tags were reset).
+   * The world mutex must be held while the index is used. */
+  class ObjectIndex {
+   public:
+    /**
+     * @param[in] world the indexed world
+     * @param[in] visTagCounter the visual tag counter of the server. A change means that tags were assigned */
+    void refresh(World *world, uint32_t visTagCounter) {
+      if (valid_ && world == world_ && world->getConfigurationNumber() == configurationNumber_ &&
+          visTagCounter == visTagCounter_)
+        return;
+
+      world_ = world;
+      configurationNumber_ = world->getConfigurationNumber();
+      visTagCounter_ = visTagCounter;
+      valid_ = true;
+      byVisualTag_.clear();
+      byName_.clear();
+      sensors_.clear();
+
+      for (auto ob: world->getObjList()) {
+        if (ob->visualTag != 0) byVisualTag_[ob->visualTag] = ob;
+        byName_.emplace(ob->getName(), ob);
+
+        if (ob->getObjectType() == ObjectType::ARTICULATED_SYSTEM) {
+          auto &sensors = sensors_[ob];
+          for (auto &sensorSet: static_cast<ArticulatedSystem *>(ob)->getSensorSets())
+            for (auto &sensor: sensorSet->getSensors())
+              sensors.emplace(sensor->getFullName(), sensor);
+        }
+      }
+    }
+
+    /// the visual tags or the names may have changed without changing the configuration number
+    void invalidate() { valid_ = false; }
+
+    /**
+     * @param[in] visualTag the visual tag assigned by the server
+     * @return the object or nullptr */
+    [[nodiscard]] Object *findByVisualTag(uint32_t visualTag) const {
+      if (visualTag == 0) return nullptr;
+      auto found = byVisualTag_.find(visualTag);
+      return found == byVisualTag_.end() || found->second->visualTag != visualTag ? nullptr : found->second;
+    }
+
+    /**
+     * @param[in] name the name of the object
+     * @return the object or nullptr. An object renamed after the last rebuild is found by a linear search */
+    [[nodiscard]] Object *findByName(const std::string &name) const {
+      auto found = byName_.find(name);
+      if (found != byName_.end() && found->second->getName() == name) return found->second;
+      if (!world_) return nullptr;
+      for (auto ob: world_->getObjList())
+        if (ob->getName() == name) return ob;
+      return nullptr;
+    }
+
+    /**
+     * @param[in] ob the articulated system that has the sensor
+     * @param[in] fullName the full name of the sensor
+     * @return the sensor or nullptr */
+    [[nodiscard]] Sensor *findSensor(Object *ob, const std::string &fullName) const {
+      auto sensors = sensors_.find(ob);
+      if (sensors == sensors_.end()) return nullptr;
+      auto found = sensors->second.find(fullName);
+      return found == sensors->second.end() ? nullptr : found->second;
+    }
+
+   private:
+    World *world_ = nullptr;
+    unsigned long configurationNumber_ = 0;
+    uint32_t visTagCounter_ = 0;
+    bool valid_ = false;
+    std::unordered_map<uint32_t, Object *> byVisualTag_;
+    std::unordered_map<std::string, Object *> byName_;
+    std::unordered_map<Object *, std::unordered_map<std::string, Sensor *>> sensors_;
+  };
+
+  /// the world mutex must be locked by the caller
+  inline Object *findObjectByVisualTag(uint32_t visualTag) {
+    objectIndex_.refresh(world_, visTagCounter);
+    return objectIndex_.findByVisualTag(visualTag);
+  }
+
+  // a serialized world, produced by the integrating thread in the snapshot mode
+  struct RenderSnapshot {
+    server::SegmentedBuffer buffer;
+    bool needsSensorUpdate = false, initializesObjects = false;
+    double sensorUpdateTime = 0.;
+    // the object of the pending focus request and its visual tag in this snapshot
+    const Object *focused = nullptr;
+    uint32_t focusedTag = 0;
+  };
+
+  /// @return true if a server request (camera, video...) is pending
+  inline bool hasServerRequests() {
+    std::lock_guard<std::mutex> guard(serverRequestMutex_);
+    return !serverRequest_.empty();
+  }
+
+  /**
+   * writes the status and the pending server requests (camera, video...) and clears them. The requests are taken under
+   * serverRequestMutex_, so the world does not have to be locked.
+   * @param[in] data the output
+   * @param[out] toBeFocusedPtr where the visual tag of the focused object is written. The caller writes the tag after
+   * update(), which assigns it. Not set in the snapshot mode
+   * @param[out] toBeFocused the focused object. Not set in the snapshot mode
+   * @param[in] snapshot the snapshot sent with the requests in the snapshot mode. The visual tag of the focused object is
+   * taken from it. A focus request on an object that is not in the snapshot yet waits for the next snapshot
+   * @return the end of the output */
+  inline char *serializeServerRequests(char *data, char **toBeFocusedPtr, Object **toBeFocused,
+                                       const RenderSnapshot *snapshot = nullptr) {
+    using namespace server;
+    Object *focused;
+    {
+      std::lock_guard<std::mutex> guard(serverRequestMutex_);
+      takenServerRequest_.swap(serverRequest_);
+      focused = toBeFocused_;
+      if (!takenServerRequest_.empty()) {
+        takenVideoName_ = videoName_;
+        takenPosition_ = position_;
+        takenLookAt_ = lookAt_;
+      }
+    }
+
+    const auto focusRequests = std::count(takenServerRequest_.begin(), takenServerRequest_.end(),
+                                          ServerRequestType::FOCUS_ON_SPECIFIC_OBJECT);
+    const bool deferFocus = snapshotMode_ && focusRequests > 0 && !(snapshot && snapshot->focused == focused);
+    if (deferFocus) {
+      std::lock_guard<std::mutex> guard(serverRequestMutex_);
+      if (std::find(serverRequest_.begin(), serverRequest_.end(), ServerRequestType::FOCUS_ON_SPECIFIC_OBJECT) ==
+          serverRequest_.end()) {
+        serverRequest_.push_back(ServerRequestType::FOCUS_ON_SPECIFIC_OBJECT);
+        toBeFocused_ = focused;
+      }
+    }
+
+    data = set(data, state_);
+    data = set(data, (int32_t) (takenServerRequest_.size() - (deferFocus ? focusRequests : 0)));
+    for (const auto &sr: takenServerRequest_) {
+      if (deferFocus && sr == ServerRequestType::FOCUS_ON_SPECIFIC_OBJECT) continue;
+      data = set(data, (int) sr);
+
+      switch (sr) {
+        case ServerRequestType::NO_REQUEST:
+        case ServerRequestType::STOP_RECORD_VIDEO:
+        case ServerRequestType::GET_SCREEN_SHOT:
+          break;
+
+        case ServerRequestType::START_RECORD_VIDEO:
+          data = set(data, takenVideoName_);
+          break;
+
+        case ServerRequestType::SET_CAMERA_TO:
+          data = set(data, takenPosition_, takenLookAt_);
+          break;
+
+        case ServerRequestType::FOCUS_ON_SPECIFIC_OBJECT:
+          if (snapshotMode_) {
+            data = set(data, snapshot->focusedTag);
+          } else {
+            *toBeFocusedPtr = data;
+            *toBeFocused = focused;
+            data = set(data, uint32_t(0));
+          }
+          break;
+
+        case ServerRequestType::SET_SCREEN_SIZE:
+          data = set(data, screenShotWidth_, screenShotHeight_);
+          break;
+      }
+    }
+
+    takenServerRequest_.clear();
+    return data;
+  }
+
+  /**
+   * Apply the requests from the client (spawning/removing objects, dragging...) to the world.
+   * The world mutex must be locked by the caller.
+   * @param[in] data pointer to the first request
+   * @param[in] clientRequestSize the number of requests
+   * @return the pointer after the last request
+   */
+  inline char *handleClientRequests(char *data, int clientRequestSize) {
+    using namespace server;
+    ClientRequestType requestType;
+
+    for (int i=0; i<clientRequestSize; i++) {
+      data = get(data, &requestType);
+      switch (requestType) {
+        case ClientRequestType::CR_ATTACH_WIRE: {
+          data = get(data, &hangingObjVisTag_, &hangingObjLocalId_, &hangingObjPos_);
+
+          // hanging rope
+          auto ob = findObjectByVisualTag(hangingObjVisTag_);
+          if (ob) {
+            interactingOb_ = ob;
+            interactingOb_->lockMutex();
+            if (interactingOb_->getObjectType() == ObjectType::ARTICULATED_SYSTEM) {
+              auto as = dynamic_cast<ArticulatedSystem *>(interactingOb_);
+              as->getPositionInBodyCoordinate(hangingObjLocalId_, hangingObjPos_, hangingObjLocalPos_);
+            } else {
+              auto sob = dynamic_cast<SingleBodyObject *>(interactingOb_);
+              Vec<3> sobPos;
+              Mat<3, 3> sobRot;
+              sob->getPosition(sobPos);
+              sob->getOrientation(0, sobRot);
+              hangingObjLocalPos_ = sobRot.transpose() * (hangingObjPos_ - sobPos);
+            }
+            interactingOb_->unlockMutex();
+          } else {
+            hangingObjLocalId_ = -1;
+          }
+        }
+          break;
+        case ClientRequestType::CR_DRAG_OBJECT: {
+          data = getInFloat(data, &wireStiffness_);
+          data = get(data, &hangingObjTargetPos_);
+        }
+          break;
+
+        case ClientRequestType::CR_REMOVE_OBJECT: {
+          uint32_t id;
+          data = get(data, &id);
+          auto ob = findObjectByVisualTag(id);
+          if (ob) {
+            world_->removeObject(ob);
+          } else {
+            auto &wireList = world_->getWires();
+            LengthConstraint *w = nullptr;
+            for (int j = 0; j < wireList.size(); j++) {
+              if (wireList[j]->visualTag == id) {
+                w = wireList[j].get();
+                break;
+              }
+            }
+            if (w)
+              world_->removeObject(w);
+          }
+        }
+          break;
+        case ClientRequestType::CR_SPAWN_BOX:
+        case ClientRequestType::CR_SPAWN_SPHERE:
+        case ClientRequestType::CR_SPAWN_CYLINDER:
+        case ClientRequestType::CR_SPAWN_CAPSULE:
+        case ClientRequestType::CR_SPAWN_HEIGHT_MAP:
+        case ClientRequestType::CR_SPAWN_MESH:
+        case ClientRequestType::CR_SPAWN_PLANE:
+        case ClientRequestType::CR_SPAWN_AS: {
+          std::string name, appearance, file;
+          float mass;
+          int bodyType;
+          Vec<3> pos, linVel, angVel;
+          Vec<6> size;
+          Vec<4> quat;
+          data = get(data, &name, &appearance, &mass);
+          data = getInFloat(data, &size, &pos, &linVel, &angVel, &quat);
+          data = get(data, &bodyType, &file);
+
+          if (requestType == ClientRequestType::CR_SPAWN_HEIGHT_MAP ||
+              requestType == ClientRequestType::CR_SPAWN_MESH ||
+              requestType == ClientRequestType::CR_SPAWN_AS) {
+            if (!raisim::fileExists(file)) {
+              RSWARN("file \""<<file<<"\" does not exist. Ignoring the spawning commnad.")
+              continue;
+            }
+          }
+
+          if (int(requestType) < 4 || requestType == ClientRequestType::CR_SPAWN_MESH) {
+            raisim::SingleBodyObject* sob = nullptr;
+
+            if (requestType == ClientRequestType::CR_SPAWN_BOX) {
+              sob = world_->addBox(size[0], size[1], size[2], mass);
+            } else if (requestType == ClientRequestType::CR_SPAWN_SPHERE) {
+              sob = world_->addSphere(size[0], mass);
+            } else if (requestType == ClientRequestType::CR_SPAWN_CYLINDER) {
+              sob = world_->addCylinder(size[0], size[1], mass);
+            } else if (requestType == ClientRequestType::CR_SPAWN_CAPSULE) {
+              sob = world_->addCapsule(size[0], size[1], mass);
+            } else if (requestType == ClientRequestType::CR_SPAWN_MESH) {
+              sob = world_->addMesh(file, mass);
+            }
+
+            if (sob) {
+              sob->setPosition(pos);
+              sob->setOrientation(quat);
+              sob->setLinearVelocity(linVel);
+              sob->setAngularVelocity(angVel);
+              sob->setName(name);
+              sob->setAppearance(appearance);
+              if (bodyType == 0) {
+                sob->setBodyType(BodyType::DYNAMIC);
+              } else if (bodyType == 1) {
+                sob->setBodyType(BodyType::KINEMATIC);
+              } else if (bodyType == 2) {
+                sob->setBodyType(BodyType::STATIC);
+              } else {
+                RSFATAL("Unknown body!")
+              }
+            }
+          } else if (requestType == ClientRequestType::CR_SPAWN_PLANE) {
+            auto ground = world_->addGround(size[0]);
+            ground->setName(name);
+          } else if (requestType == ClientRequestType::CR_SPAWN_HEIGHT_MAP) {
+            auto hm = world_->addHeightMap(file, size[0], size[1], size[2], size[3], size[4], size[5]);
+            hm->setName(name);
+          } else if (requestType == ClientRequestType::CR_SPAWN_AS) {
+            auto as = world_->addArticulatedSystem(file);
+            as->setName(name);
+            as->setBasePos(pos);
+            as->setBaseOrientation(quat);
+          }
+        }
+          break;
+
+        case ClientRequestType::CR_SAVE_THE_WORLD: {
+          std::string path;
+          data = get(data, &path);
+          world_->exportToXml(path);
+        }
+          break;
+        default:
+          break;
+      }
+    }
+    return data;
+  }
+
+  /// the second half of processRequests in the snapshot mode. It does not lock the world
+  inline bool processRequestsWithSnapshot() {
+    using namespace server;
+    int clientRequestSize;
+    rData_ = get(rData_, &clientRequestSize);
+    deferClientRequests(rData_, clientRequestSize, &receive_buffer[0] + receivedDataSize_);
+
+    RenderSnapshot *snapshot = nullptr;
+    if (state_ != Status::STATUS_HIBERNATING)
+      snapshot = acquireSnapshot();
+
+    char *data = set(&send_buffer[0] + sizeof(int), version_);
+    data = serializeServerRequests(data, nullptr, nullptr, snapshot);
+
+    // the snapshot is not modified until the next one is acquired
+    if (!sendData(data, snapshot ? &snapshot->buffer : nullptr))
+      return false;
+
+    if (snapshot && snapshot->needsSensorUpdate)
+      if (!receiveSensorMeasurements(snapshot->sensorUpdateTime))
+        return false;
+
+    return state_ == STATUS_RENDERING || state_ == STATUS_HIBERNATING;
+  }
+
+  /// receive the sensor measurements rendered by the visualizer
+  inline bool receiveSensorMeasurements(double updateTime) {
+    using namespace server;
+    if (!receiveData(5))
+      return false;
+
+    /// send dummy data to let visualizer know that receive is done
+    sendData(set(&send_buffer[0] + sizeof(int), version_));
+    updateSensorMeasurements(updateTime);
+    return true;
+  }
+
+  /// copy the client requests. They are applied to the world in the next integrateWorldThreadSafe call
+  inline void deferClientRequests(const char *data, int clientRequestSize, const char *dataEnd) {
+    std::lock_guard<std::mutex> guard(deferredRequestMutex_);
+    deferredRequests_.emplace_back(clientRequestSize, std::vector<char>(data, dataEnd));
+  }
+
+  /// the world mutex must be locked by the caller
+  inline void applyDeferredClientRequests() {
+    std::lock_guard<std::mutex> guard(deferredRequestMutex_);
+    for (auto &request: deferredRequests_) {
+      wireStiffness_ = 0.;
+      handleClientRequests(request.second.data(), request.first);
+    }
+    deferredRequests_.clear();
+  }
+
+  /// serialize the world into the free snapshot buffer and publish it. The world mutex must be locked by the caller
+  inline void publishSnapshot() {
+    applyDeferredClientRequests();
+    auto &snapshot = snapshots_[snapshotWriteIdx_];
+    needsSensorUpdate_ = false;
+    uint32_t visTagCounterBefore = visTagCounter;
+    update(snapshot.buffer);
+    snapshot.initializesObjects = visTagCounter != visTagCounterBefore;
+    snapshot.needsSensorUpdate = needsSensorUpdate_;
+    snapshot.sensorUpdateTime = sensorUpdateTime_;
+    needsSensorUpdate_ = false;
+    {
+      std::lock_guard<std::mutex> guard(serverRequestMutex_);
+      const bool focusing = std::find(serverRequest_.begin(), serverRequest_.end(),
+                                      ServerRequestType::FOCUS_ON_SPECIFIC_OBJECT) != serverRequest_.end();
+      snapshot.focused = focusing ? toBeFocused_ : nullptr;
+    }
+    snapshot.focusedTag = snapshot.focused ? snapshot.focused->visualTag : 0u;
+    publishedSnapshot_.store(&snapshot, std::memory_order_release);
+    snapshotWriteIdx_ ^= 1;
+  }
+
+  /// take the latest snapshot. If the simulation is not stepping, the server thread serializes the world by itself
+  inline RenderSnapshot *acquireSnapshot() {
+    auto start = std::chrono::steady_clock::now();
+    RenderSnapshot *snapshot;
+
+    while (!(snapshot = publishedSnapshot_.exchange(nullptr, std::memory_order_acquire))) {
+      if (std::chrono::steady_clock::now() - start > std::chrono::microseconds(SNAPSHOT_TIMEOUT_US)) {
+        lockVisualizationServerMutex();
+        if (!publishedSnapshot_.load(std::memory_order_acquire)) publishSnapshot();
+        unlockVisualizationServerMutex();
+      } else {
+        USLEEP(50);
+      }
+    }
+    return snapshot;
+  }
+
+#if __linux__ || __APPLE__
+  /// the server loop of Transport::SHARED_MEMORY. It returns when the termination is requested
+  inline void runSharedMemoryLoop(int port) {
+    using namespace server;
+    SharedMemoryRingWriter ring(sharedMemoryName(port), uint32_t(sharedMemorySlots_), sharedMemorySlotCapacity_,
+                                mode_t(sharedMemoryPermissions_));
+    uint32_t resyncRequests = ring.getResyncRequests();
+    double lastPublishedTime = -1.;
+    bool warned = false;
+    frameCapabilities_ = 0;
+    connected_ = true;
+
+    while (!terminateRequested_) {
+      if (state_ == STATUS_HIBERNATING) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100000));
+        continue;
+      }
+
+      // a reader that attached or skipped frames needs all objects again
+      bool resync = ring.getResyncRequests() != resyncRequests;
+      if (resync) {
+        resyncRequests = ring.getResyncRequests();
+        clearScene();
+      }
+
+      char *data = set(&send_buffer[0] + sizeof(int), version_);
+      char *toBeFocusedPtr = nullptr;
+      Object *toBeFocused = nullptr;
+      const SegmentedBuffer *body;
+
+      if (snapshotMode_) {
+        RenderSnapshot *snapshot = resync ? acquireSnapshot() : publishedSnapshot_.exchange(nullptr, std::memory_order_acquire);
+        if (!snapshot) {
+          USLEEP(100);
+          continue;
+        }
+        data = serializeServerRequests(data, nullptr, nullptr, snapshot);
+        body = &snapshot->buffer;
+      } else {
+        tryingToLock_ = true;
+        lockVisualizationServerMutex();
+        tryingToLock_ = false;
+        if (!resync && world_->getWorldTime() == lastPublishedTime && !hasServerRequests()) {
+          unlockVisualizationServerMutex();
+          USLEEP(100);
+          continue;
+        }
+
+        lastPublishedTime = world_->getWorldTime();
+        data = serializeServerRequests(data, &toBeFocusedPtr, &toBeFocused);
+        update(output_);
+        body = &output_;
+        if (toBeFocusedPtr)
+          set(toBeFocusedPtr, toBeFocused->visualTag);
+        needsSensorUpdate_ = false;
+        unlockVisualizationServerMutex();
+      }
+
+      auto headerSize = size_t(data - &send_buffer[0]);
+      set(&send_buffer[0], int(headerSize + body->size()));
+      segments_.assign(1, {&send_buffer[0], headerSize});
+      segments_.insert(segments_.end(), body->getSegments().begin(), body->getSegments().end());
+
+      if (!ring.publish(segments_) && !warned) {
+        RSWARN("A frame of " << headerSize + body->size() << " bytes does not fit in the shared memory ring ("
+                             << ring.getSlotCapacity() << " bytes per slot). Increase it with setSharedMemoryRing")
+        warned = true;
+      }
+    }
+
+    connected_ = false;
+  }
+#endif
+
+  // a serialized frame shared by all clients. It is not modified once it is created
+  struct SharedFrame {
+    std::vector<char> buffer, compressedBuffer;
+    uint64_t id = 0;
+    bool needsSensorUpdate = false, initializesObjects = false;
+    double sensorUpdateTime = 0.;
+  };
+
+  struct ClientConnection {
+    int fd = -1;
+    uint64_t order = 0, lastFrameId = 0;
+    int capabilities = 0;
+    bool isPrimary = false, pollsOut = false;
+    int pendingRequests = 0;
+    double sensorUpdateTime = 0.;
+    std::vector<char> received;
+    size_t receivedSize = 0, sentBytes = 0;
+    std::deque<std::shared_ptr<const std::vector<char>>> outgoing;
+    std::chrono::steady_clock::time_point lastActivity;
+  };
+
+#if __linux__
+  /// the server loop for multiple clients and the pipelined mode. It returns when the termination is requested
+  inline void runEventLoop() {
+    int epollFd = epoll_create1(0);
+    RSFATAL_IF(epollFd < 0, "epoll error, errno: " << errno)
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = server_fd_;
+    RSFATAL_IF(epoll_ctl(epollFd, EPOLL_CTL_ADD, server_fd_, &event) < 0, "epoll error, errno: " << errno)
+    std::vector<epoll_event> events(maxClients_ + 1);
+
+    auto ack = std::make_shared<SharedFrame>();
+    ack->buffer.resize(2 * sizeof(int));
+    server::set(server::set(ack->buffer.data(), int(ack->buffer.size())), version_);
+
+    while (!terminateRequested_) {
+      bool ready = std::any_of(clients_.begin(), clients_.end(), [](const std::pair<const int, ClientConnection> &c) {
+        return c.second.pendingRequests > 0 && c.second.outgoing.empty();
+      });
+      int nEvents = epoll_wait(epollFd, events.data(), int(events.size()), ready ? 0 : 10);
+
+      for (int i = 0; i < nEvents; i++) {
+        if (events[i].data.fd == server_fd_) {
+          acceptClient(epollFd);
+          continue;
+        }
+
+        auto client = clients_.find(events[i].data.fd);
+        if (client == clients_.end()) continue;
+        bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP));
+        if (alive && (events[i].events & EPOLLIN))
+          alive = receiveFromClient(client->second, ack);
+        if (!alive) dropClient(epollFd, client->first);
+      }
+
+      sendFrameToWaitingClients();
+
+      auto now = std::chrono::steady_clock::now();
+      for (auto client = clients_.begin(); client != clients_.end();) {
+        auto &c = client->second;
+        bool alive = sendToClient(c) &&
+            (c.outgoing.empty() ? c.pendingRequests > 0 || now - c.lastActivity < std::chrono::seconds(CLIENT_TIMEOUT_S)
+                                : now - c.lastActivity < std::chrono::seconds(1));
+        if (alive && c.pollsOut == c.outgoing.empty()) {
+          c.pollsOut = !c.outgoing.empty();
+          epoll_event clientEvent{};
+          clientEvent.events = c.pollsOut ? EPOLLIN | EPOLLOUT : EPOLLIN;
+          clientEvent.data.fd = c.fd;
+          epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &clientEvent);
+        }
+        ++client;
+        if (!alive) {
+          RSWARN("The client " << c.fd << " failed to communicate. Closing the connection")
+          dropClient(epollFd, c.fd);
+        }
+      }
+
+      connected_ = !clients_.empty();
+      if (pipelining_) produceFrameAhead();
+      if (state_ == STATUS_HIBERNATING)
+        std::this_thread::sleep_for(std::chrono::microseconds(100000));
+    }
+
+    while (!clients_.empty()) dropClient(epollFd, clients_.begin()->first);
+    close(epollFd);
+    connected_ = false;
+  }
+
+  inline void acceptClient(int epollFd) {
+    int fd = accept4(server_fd_, nullptr, nullptr, SOCK_NONBLOCK);
+    if (fd < 0) return;
+
+    if (int(clients_.size()) >= maxClients_) {
+      RSWARN("The maximum number of clients (" << maxClients_ << ") is reached. Connection refused")
+      close(fd);
+      return;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+      close(fd);
+      return;
+    }
+
+    auto &client = clients_[fd];
+    client.fd = fd;
+    client.order = ++clientCounter_;
+    client.lastFrameId = frameCounter_;
+    client.lastActivity = std::chrono::steady_clock::now();
+    client.isPrimary = std::none_of(clients_.begin(), clients_.end(),
+                                    [](const std::pair<const int, ClientConnection> &c) { return c.second.isPrimary; });
+    RSINFO("Connection to " << fd << " is established")
+
+    // the new client has to receive all objects
+    clearScene();
+    latestFrame_.reset();
+  }
+
+  inline void dropClient(int epollFd, int fd) {
+    auto client = clients_.find(fd);
+    if (client == clients_.end()) return;
+    bool wasPrimary = client->second.isPrimary;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    clients_.erase(client);
+
+    if (wasPrimary && !clients_.empty())
+      std::min_element(clients_.begin(), clients_.end(),
+                       [](const std::pair<const int, ClientConnection> &a,
+                          const std::pair<const int, ClientConnection> &b) {
+                         return a.second.order < b.second.order;
+                       })->second.isPrimary = true;
+  }
+
+  /// read everything available from the client and handle the complete messages
+  inline bool receiveFromClient(ClientConnection &client, const std::shared_ptr<const SharedFrame> &ack) {
+    while (true) {
+      if (client.received.size() - client.receivedSize < MAXIMUM_PACKET_SIZE)
+        client.received.resize(client.received.size() * 2 + MAXIMUM_PACKET_SIZE);
+
+      auto bytes = recv(client.fd, client.received.data() + client.receivedSize,
+                        client.received.size() - client.receivedSize, 0);
+      if (bytes == 0) return false;
+      if (bytes < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        if (errno == EINTR) continue;
+        return false;
+      }
+      client.receivedSize += size_t(bytes);
+      client.lastActivity = std::chrono::steady_clock::now();
+    }
+
+    size_t offset = 0;
+    while (client.receivedSize - offset >= sizeof(int)) {
+      int messageSize;
+      server::get(client.received.data() + offset, &messageSize);
+      if (messageSize < int(sizeof(int)) || messageSize > RECEIVE_BUFFER_SIZE) return false;
+      if (client.receivedSize - offset < size_t(messageSize)) break;
+
+      char *message = client.received.data() + offset;
+      if (!handleClientMessage(client, message, message + messageSize, ack)) return false;
+      offset += size_t(messageSize);
+    }
+
+    memmove(client.received.data(), client.received.data() + offset, client.receivedSize - offset);
+    client.receivedSize -= offset;
+    return true;
+  }
+
+  inline bool handleClientMessage(ClientConnection &client, char *message, char *messageEnd,
+                                  const std::shared_ptr<const SharedFrame> &ack) {
+    using namespace server;
+    int clientVersion, clientRequestSize;
+    ClientMessageType type;
+    uint32_t objectId;
+    char *data = get(message + sizeof(int), &clientVersion);
+
+    // sensor measurements start with the message type instead of the version
+    if (clientVersion == ClientMessageType::REQUEST_SENSOR_UPDATE) {
+      if (client.isPrimary) {
+        rData_ = message + sizeof(int);
+        updateSensorMeasurements(client.sensorUpdateTime);
+      }
+      queueFrame(client, ack);
+      return true;
+    }
+
+    client.capabilities = clientVersion & ~VERSION_MASK;
+    clientVersion &= VERSION_MASK;
+    if (clientVersion != version_) {
+      RSWARN("Version mismatch. Raisim protocol version: "<<version_<<", Visualizer protocol version: "<<clientVersion)
+      return false;
+    }
+    data = get(data, &type, &objectId, &clientRequestSize);
+    objectId_ = objectId;
+
+    // the primary client behaves like the only client. The empty requests of the other clients are ignored
+    if (client.isPrimary || clientRequestSize > 0) {
+      if (snapshotMode_) {
+        deferClientRequests(data, clientRequestSize, messageEnd);
+      } else {
+        tryingToLock_ = true;
+        lockVisualizationServerMutex();
+        tryingToLock_ = false;
+        wireStiffness_ = 0.;
+        handleClientRequests(data, clientRequestSize);
+        unlockVisualizationServerMutex();
+      }
+    }
+
+    // the requests take effect in the next frame. A frame produced ahead is still sent
+    if (clientRequestSize > 0 && !pipelining_) latestFrame_.reset();
+    client.pendingRequests++;
+    return true;
+  }
+
+  /// send the latest frame to all clients waiting for a frame. A new frame is serialized only if one of them already has it
+  inline void sendFrameToWaitingClients() {
+    // the shared frame can only use the capabilities of all clients
+    int capabilities = ~0;
+    for (auto &client: clients_) capabilities &= client.second.capabilities;
+    frameCapabilities_ = capabilities;
+
+    bool waiting = false, needsNewFrame = !latestFrame_;
+    for (auto &client: clients_) {
+      if (client.second.pendingRequests == 0 || !client.second.outgoing.empty()) continue;
+      waiting = true;
+      needsNewFrame = needsNewFrame || client.second.lastFrameId >= latestFrame_->id;
+    }
+    if (!waiting) return;
+
+    if (needsNewFrame) produceFrame();
+
+    bool resync = false, keyframe = false;
+    for (auto &client: clients_) {
+      auto &c = client.second;
+      if (c.pendingRequests == 0 || !c.outgoing.empty()) continue;
+      auto frame = latestFrame_;
+
+      // a client that skipped a frame initializing objects receives that frame first
+      if (lastInitFrame_ && lastInitFrame_->id > c.lastFrameId && lastInitFrame_ != latestFrame_) {
+        if (previousInitFrameId_ > c.lastFrameId)
+          resync = true;
+        else
+          frame = lastInitFrame_;
+      }
+      keyframe = keyframe || (deltaEncoding_ && frame->id > c.lastFrameId + 1);
+
+      c.lastFrameId = frame->id;
+      c.pendingRequests--;
+      if (frame->needsSensorUpdate) c.sensorUpdateTime = frame->sensorUpdateTime;
+      queueFrame(c, frame);
+    }
+
+    if (resync) {
+      clearScene();
+      latestFrame_.reset();
+    } else if (keyframe) {
+      lockVisualizationServerMutex();
+      framesSinceKeyframe_ = 0;
+      unlockVisualizationServerMutex();
+    }
+  }
+
+  inline void produceFrame() {
+    latestFrame_ = serializeSharedFrame();
+    if (latestFrame_->initializesObjects) {
+      previousInitFrameId_ = lastInitFrame_ ? lastInitFrame_->id : 0;
+      lastInitFrame_ = latestFrame_;
+    }
+  }
+
+  /// serialize the next frame once all clients have the latest one
+  inline void produceFrameAhead() {
+    if (clients_.empty() || state_ == STATUS_HIBERNATING) return;
+    if (snapshotMode_ && !publishedSnapshot_.load(std::memory_order_acquire)) return;
+    if (latestFrame_ && std::any_of(clients_.begin(), clients_.end(), [this](const std::pair<const int, ClientConnection> &c) {
+      return c.second.lastFrameId < latestFrame_->id;
+    })) return;
+    produceFrame();
+  }
+
+  inline std::shared_ptr<const SharedFrame> serializeSharedFrame() {
+    using namespace server;
+    auto frame = std::make_shared<SharedFrame>();
+    frame->id = ++frameCounter_;
+    char *data = set(&send_buffer[0] + sizeof(int), version_);
+    char *toBeFocusedPtr = nullptr;
+    Object *toBeFocused = nullptr;
+    const server::SegmentedBuffer *body = nullptr;
+
+    if (snapshotMode_) {
+      RenderSnapshot *snapshot = nullptr;
+      if (state_ != Status::STATUS_HIBERNATING) {
+        snapshot = acquireSnapshot();
+        body = &snapshot->buffer;
+        frame->needsSensorUpdate = snapshot->needsSensorUpdate;
+        frame->sensorUpdateTime = snapshot->sensorUpdateTime;
+        frame->initializesObjects = snapshot->initializesObjects;
+      }
+      data = serializeServerRequests(data, nullptr, nullptr, snapshot);
+    } else {
+      tryingToLock_ = true;
+      lockVisualizationServerMutex();
+      tryingToLock_ = false;
+      data = serializeServerRequests(data, &toBeFocusedPtr, &toBeFocused);
+      uint32_t visTagCounterBefore = visTagCounter;
+      needsSensorUpdate_ = false;
+
+      if (state_ != Status::STATUS_HIBERNATING) {
+        update(output_);
+        body = &output_;
+      }
+
+      if (toBeFocusedPtr)
+        set(toBeFocusedPtr, toBeFocused->visualTag);
+
+      frame->needsSensorUpdate = needsSensorUpdate_;
+      frame->sensorUpdateTime = sensorUpdateTime_;
+      frame->initializesObjects = visTagCounter != visTagCounterBefore;
+      needsSensorUpdate_ = false;
+      unlockVisualizationServerMutex();
+    }
+
+    auto headerSize = size_t(data - &send_buffer[0]);
+    frame->buffer.resize(headerSize + (body ? body->size() : 0));
+    memcpy(frame->buffer.data(), &send_buffer[0], headerSize);
+    if (body) body->copyTo(frame->buffer.data() + headerSize);
+    set(frame->buffer.data(), int(frame->buffer.size()));
+
+    if (compressionLevel_ > 0 && frame->buffer.size() > compressionThreshold_ &&
+        std::any_of(clients_.begin(), clients_.end(), [](const std::pair<const int, ClientConnection> &c) {
+          return c.second.capabilities & CAPABILITY_ZLIB;
+        }))
+      compressFrame({{frame->buffer.data(), frame->buffer.size()}}, frame->compressedBuffer);
+    return frame;
+  }
+
+  inline void queueFrame(ClientConnection &client, const std::shared_ptr<const SharedFrame> &frame) {
+    if (client.outgoing.empty()) client.lastActivity = std::chrono::steady_clock::now();
+    bool compressed = (client.capabilities & CAPABILITY_ZLIB) && !frame->compressedBuffer.empty();
+    client.outgoing.emplace_back(frame, compressed ? &frame->compressedBuffer : &frame->buffer);
+  }
+
+  /// write as much as the socket accepts without blocking
+  inline bool sendToClient(ClientConnection &client) {
+    while (!client.outgoing.empty()) {
+      auto &buffer = *client.outgoing.front();
+      auto bytes = send(client.fd, buffer.data() + client.sentBytes, buffer.size() - client.sentBytes, MSG_NOSIGNAL);
+      if (bytes < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        if (errno == EINTR) continue;
+        return false;
+      }
+      client.sentBytes += size_t(bytes);
+      client.lastActivity = std::chrono::steady_clock::now();
+      if (client.sentBytes == buffer.size()) {
+        client.outgoing.pop_front();
+        client.sentBytes = 0;
+      }
+    }
+    return true;
+  }
+#endif
+
   static inline std::string colorToString(const raisim::Vec<4> &vec) {
     std::string str;
     for (int i = 0; i < vec.size() - 1; i++) {
@@ -1328,8 +2220,91 @@ class RaisimServer final {
     return str;
   }
 
+  /// records that the object is part of the current frame.
+  /// returns true if its state did not change more than deltaEpsilon_ since it was last sent
+  inline bool isUnchanged(uint32_t visualTag, bool initialized, const std::string &appearance, bool forceSend) {
+    auto &sent = sentState_[visualTag];
+    sent.lastFrame = deltaFrame_;
+    deltaSeen_++;
+
+    bool unchanged = initialized && !forceSend && !isKeyframe_ &&
+        sent.state.size() == deltaState_.size() && sent.appearance == appearance;
+    for (size_t i = 0; unchanged && i < deltaState_.size(); i++)
+      unchanged = std::abs(sent.state[i] - deltaState_[i]) <= deltaEpsilon_;
+
+    // the reference is not updated for skipped objects so that slow drifts are eventually sent
+    if (!unchanged) {
+      sent.state = deltaState_;
+      sent.appearance = appearance;
+    }
+    return unchanged;
+  }
+
+  inline void markAsSent(uint32_t visualTag) {
+    deltaState_.clear();
+    isUnchanged(visualTag, false, std::string(), true);
+  }
+
+  inline void appendDeltaState(const double *ptr, size_t n) {
+    deltaState_.insert(deltaState_.end(), ptr, ptr + n);
+  }
+
+  inline bool isUnchangedSinceLastSent(Object *ob, bool initialized) {
+    deltaState_.clear();
+    if (ob->getObjectType() == ObjectType::ARTICULATED_SYSTEM) {
+      auto as = dynamic_cast<ArticulatedSystem *>(ob);
+      appendDeltaState(as->getGeneralizedCoordinate().ptr(), as->getGeneralizedCoordinate().n);
+      // sensor requests are part of the articulated system
+      return isUnchanged(ob->visualTag, initialized, std::string(), !as->getSensorSets().empty());
+    }
+
+    auto *sob = dynamic_cast<SingleBodyObject *>(ob);
+    Vec<3> pos;
+    Vec<4> quat;
+    sob->getPosition(pos);
+    sob->getQuaternion(quat);
+    appendDeltaState(pos.ptr(), 3);
+    appendDeltaState(quat.ptr(), 4);
+    bool forceSend = ob->getObjectType() == ObjectType::HEIGHTMAP && isHeightMapChanged(dynamic_cast<HeightMap *>(ob));
+    return isUnchanged(ob->visualTag, initialized, sob->getAppearance(), forceSend);
+  }
+
+  inline bool isUnchangedSinceLastSent(LengthConstraint *sw, bool initialized) {
+    deltaState_.clear();
+    appendDeltaState(sw->getP1().ptr(), 3);
+    appendDeltaState(sw->getP2().ptr(), 3);
+    appendDeltaState(sw->getColor().ptr(), 4);
+    deltaState_.push_back(sw->getVisualizationWidth());
+    return isUnchanged(sw->visualTag, initialized, std::string(), false);
+  }
+
+  inline bool isUnchangedSinceLastSent(Visuals *vo, bool initialized) {
+    deltaState_.clear();
+    appendDeltaState(vo->position.ptr(), 3);
+    appendDeltaState(vo->quaternion.ptr(), 4);
+    appendDeltaState(vo->size.ptr(), 4);
+    appendDeltaState(vo->color.ptr(), 4);
+    bool forceSend = vo->type == Shape::Mesh && reinterpret_cast<VisualMesh *>(vo)->isUpdated();
+    return isUnchanged(vo->visualTag, initialized, std::string(), forceSend);
+  }
+
+  inline bool isUnchangedSinceLastSent(ArticulatedSystemVisual *vis, bool initialized) {
+    deltaState_.clear();
+    appendDeltaState(vis->obj.getGeneralizedCoordinate().ptr(), vis->obj.getGeneralizedCoordinate().n);
+    appendDeltaState(vis->color.ptr(), 4);
+    return isUnchanged(vis->obj.visualTag, initialized, std::string(), false);
+  }
+
+  inline bool isUnchangedSinceLastSent(HeightMap *hm, bool initialized) {
+    deltaState_.clear();
+    appendDeltaState(hm->getPosition().data(), 3);
+    appendDeltaState(hm->getQuaternion().data(), 4);
+    return isUnchanged(hm->visualTag, initialized, hm->getAppearance(), isHeightMapChanged(hm));
+  }
+
   inline void serializeAS(ArticulatedSystem* as, bool initialized, const raisim::Vec<4>& colorOverride) {
     using namespace server;
+    reserveOutput(byteSize(as->name_));
     data_ = set(data_, (int32_t) (as->getVisOb().size() + as->getVisColOb().size()));
     if (!initialized) data_ = set(data_, as->name_);
 
@@ -1339,6 +2314,8 @@ class RaisimServer final {
       else visVec = &as->getVisColOb();
 
       for (int j = 0; j < visVec->size(); j++) {
+        const std::string color = colorToString(colorOverride[3] < 0.001 ? visVec->at(j).color : colorOverride);
+        reserveOutput(byteSize(visVec->at(j).fileName) + byteSize(as->getResourceDir()) + byteSize(color));
         if (!initialized) {
           data_ = set(data_, visVec->at(j).shape);
           if (visVec->at(j).shape == Shape::Mesh) {
@@ -1351,10 +2328,7 @@ class RaisimServer final {
         if (visVec->at(j).shape == Shape::Mesh)
           data_ = set(data_, int(false));
 
-        if (colorOverride[3] < 0.001)
-          data_ = set(data_, colorToString(visVec->at(j).color));
-        else
-          data_ = set(data_, colorToString(colorOverride));
+        data_ = set(data_, color);
 
         if (visVec->at(j).shape == Shape::Mesh)
           data_ = setInFloat(data_, visVec->at(j).scale, 0.);
@@ -1379,7 +2353,7 @@ class RaisimServer final {
         matmul(bodyRotation, oriOffset, rot);
         raisim::rotMatToQuat(rot, quat);
         pos = pos + offsetInWorld;
-        data_ = setInFloat(data_, pos, quat);
+        setPose(pos, quat);
       }
     }
 
@@ -1394,6 +2368,10 @@ class RaisimServer final {
     for (auto &sensorSet: as->getSensorSets()) {
       for (auto& sensor : sensorSet->getSensors()) {
         sensor->lockMutex();
+        if (sensor->getType() == Sensor::Type::SPINNING_LIDAR)
+          reserveOutput(propertyByteSize(sensor) + dynamic_cast<SpinningLidar *>(sensor)->getScan().size() * 3 * sizeof(double));
+        else
+          reserveOutput(propertyByteSize(sensor));
         if (!initialized) data_ = sensor->serializeProp(data_);
 
         data_ = set(data_, sensor->getMeasurementSource());
@@ -1413,7 +2391,7 @@ class RaisimServer final {
         auto &pos = sensor->getPosition();
         auto &rot = sensor->getOrientation();
         rotMatToQuat(rot, quat);
-        data_ = setInFloat(data_, pos, quat);
+        setPose(pos, quat);
 
         if (sensor->getMeasurementSource() != Sensor::MeasurementSource::VISUALIZER)
           data_ = sensor->serializeMeasurements(data_);
@@ -1423,20 +2401,152 @@ class RaisimServer final {
     }
   }
 
-  inline void update() {
+  /// the space needed by variable-length fields is reserved before they are written. The fixed-size rest fits in the headroom
+  inline void reserveOutput(size_t bytes) { data_ = outputBuffer_->reserve(data_, bytes); }
+
+  inline void setPose(const Vec<3> &pos, const Vec<4> &quat) {
+    using namespace server;
+    if (quantize_) {
+      data_ = setQuantized(data_, pos, quantizationOrigin_, positionResolution_);
+      data_ = setQuantized(data_, quat);
+      originSum_ += pos;
+      originSamples_++;
+    } else {
+      data_ = setInFloat(data_, pos, quat);
+    }
+  }
+
+  inline void setHeights(const std::vector<double> &heights) {
+    using namespace server;
+    data_ = quantize_ ? setQuantizedHeights(data_, heights) : setInFloat(data_, heights);
+  }
+
+  inline size_t heightMapByteSize(const HeightMap *hm) {
+    return hm->getHeightVector().size() * sizeof(float) + server::byteSize(hm->getColorMap());
+  }
+
+  /// @return the number of bytes of the strings that Sensor::serializeProp writes
+  static inline size_t propertyByteSize(Sensor *sensor) {
+    switch (sensor->getType()) {
+      case Sensor::Type::RGB:
+        return server::byteSize(static_cast<RGBCamera *>(sensor)->getProperties().full_name);
+      case Sensor::Type::DEPTH:
+        return server::byteSize(static_cast<DepthCamera *>(sensor)->getProperties().full_name);
+      case Sensor::Type::IMU:
+        return server::byteSize(static_cast<InertialMeasurementUnit *>(sensor)->getProperties().full_name);
+      case Sensor::Type::SPINNING_LIDAR:
+        return server::byteSize(static_cast<SpinningLidar *>(sensor)->getProperties().full_name);
+      default:
+        return 0;
+    }
+  }
+
+  inline bool isHeightMapChanged(const HeightMap *hm) {
+    if (hm->isUpdated()) return true;
+    auto regions = heightMapRegions_.find(hm);
+    return regions != heightMapRegions_.end() && !regions->second.empty();
+  }
+
+  /// the rectangles of a frame that is not delivered would be lost
+  inline bool canSendHeightMapRegions() const {
+    return (frameCapabilities_ & CAPABILITY_HEIGHTMAP_REGIONS) && maxClients_ == 1 && !pipelining_ && !snapshotMode_ &&
+        transport_ == Transport::TCP;
+  }
+
+  /// [0] (unchanged), [1][all heights] or [2][changed rectangles] (see getHeightMapRegions)
+  inline void serializeHeightMapUpdate(HeightMap *hm, bool initialized) {
+    using namespace server;
+    int updateType = hm->isUpdated() ? 1 : 0;
+    auto found = heightMapRegions_.find(hm);
+
+    // the heights were sent with the initialization if it is not initialized
+    if (found != heightMapRegions_.end() && !found->second.empty()) {
+      auto &regions = found->second;
+      if (initialized && updateType == 0) {
+        if (!canSendHeightMapRegions()) {
+          hm->setUpdatedTrue();
+          updateType = 1;
+        } else {
+          updateType = 2 * regions.getNumberOfSamples() < hm->getHeightVector().size() ? 2 : 1;
+        }
+      }
+      if (updateType == 2) serializeHeightMapRegions(hm, regions);
+      regions.clear();
+    }
+    if (updateType == 2) return;
+
+    data_ = set(data_, updateType);
+    if (updateType == 1) {
+      data_ = setInFloat(data_, hm->getCenterX(), hm->getCenterY(), hm->getXSize(), hm->getYSize());
+      data_ = set(data_, (int32_t) hm->getXSamples(), (int32_t) hm->getYSamples());
+      setHeights(hm->getHeightVector());
+      data_ = set(data_, hm->getColorMap());
+    }
+  }
+
+  inline void serializeHeightMapRegions(const HeightMap *hm, const HeightMapRegions &regions) {
+    using namespace server;
+    const auto &heights = hm->getHeightVector();
+    const size_t xSamples = hm->getXSamples();
+    data_ = set(data_, int(2), (int32_t) regions.getRectangles().size());
+    for (const auto &r: regions.getRectangles()) {
+      reserveOutput(8 * sizeof(int32_t) + r.area() * sizeof(float));
+      data_ = set(data_, (int32_t) r.x0, (int32_t) r.y0, (int32_t) r.width, (int32_t) r.height);
+      regionHeights_.resize(r.area());
+      for (size_t j = 0; j < r.height; j++)
+        std::copy_n(&heights[r.x0 + (r.y0 + j) * xSamples], r.width, &regionHeights_[j * r.width]);
+      setHeights(regionHeights_);
+    }
+  }
+
+  /// drop the regions of the heightmaps that were removed
+  inline void pruneHeightMapRegions() {
+    for (auto it = heightMapRegions_.begin(); it != heightMapRegions_.end();) {
+      const Object *hm = it->first;
+      const bool exists = std::find(world_->getObjList().begin(), world_->getObjList().end(), hm) != world_->getObjList().end() ||
+          std::any_of(visualHm_.begin(), visualHm_.end(), [hm](const std::pair<const std::string, HeightMapVisual *> &v) {
+            return &v.second->obj == hm;
+          });
+      it = exists ? std::next(it) : heightMapRegions_.erase(it);
+    }
+  }
+
+  /// serialize the world into the buffer
+  inline void update(server::SegmentedBuffer &buffer) {
     using namespace server;
     auto &objList = world_->getObjList();
-    data_ = set(data_, ServerMessageType::UPDATE_ALL);
+    outputBuffer_ = &buffer;
+    data_ = buffer.reset();
+    reserveOutput(byteSize(mapName_));
+    if (!heightMapRegions_.empty()) pruneHeightMapRegions();
+    quantize_ = quantization_ && (frameCapabilities_ & CAPABILITY_QUANTIZED);
+    int messageType = ServerMessageType::UPDATE_ALL;
+
+    if (deltaEncoding_) {
+      deltaFrame_++;
+      deltaSeen_ = 0;
+      isKeyframe_ = framesSinceKeyframe_ == 0;
+      framesSinceKeyframe_ = (framesSinceKeyframe_ + 1) % keyframeInterval_;
+      messageType = ServerMessageType::UPDATE_DELTA | (isKeyframe_ ? ServerMessageType::KEYFRAME : 0);
+    }
+
+    if (quantize_) {
+      // the origin follows the objects so that the fixed-point positions stay small
+      if (originSamples_ > 0)
+        for (int i = 0; i < 3; i++) quantizationOrigin_[i] = std::round(originSum_[i] / originSamples_);
+      originSum_.setZero();
+      originSamples_ = 0;
+      data_ = set(data_, messageType | ServerMessageType::QUANTIZED, quantizationOrigin_, positionResolution_);
+    } else {
+      data_ = set(data_, messageType);
+    }
     data_ = set(data_, (double) world_->getWorldTime());
     data_ = set(data_, mapName_);
     data_ = set(data_, (uint32_t) (world_->getConfigurationNumber() + visualConfiguration_));
-    data_ = set(data_, (uint32_t) (objList.size() +
-        visuals_.size() +
-        instancedvisuals_.size() +
-        visualAs_.size() +
-        visualHm_.size() +
-        polyLines_.size() +
-        world_->getWires().size()));
+
+    auto objectSizeLocation = data_;
+    uint32_t objectSize = 0;
+    data_ = set(data_, objectSize); // reserving space
 
     /// UniqueVisualTag/IsInitialized/Name/IsVisual/ObjectType/Instanced/
     /// VisualSize/{IfNotInitialized:[VisualType/VisualDescription/Masking]/
@@ -1448,6 +2558,17 @@ class RaisimServer final {
       // set gc
       bool initialized = ob->visualTag != 0;
       if (!initialized) ob->visualTag = visTagCounter++;
+      if (deltaEncoding_ && isUnchangedSinceLastSent(ob, initialized)) {
+        ob->unlockMutex();
+        continue;
+      }
+      objectSize++;
+      size_t bytes = byteSize(ob->name_);
+      // a heightmap can be sent twice (initialization and update)
+      if (ob->getObjectType() == ObjectType::HEIGHTMAP) bytes += 2 * heightMapByteSize(dynamic_cast<HeightMap *>(ob));
+      if (ob->getObjectType() == ObjectType::MESH) bytes += byteSize(dynamic_cast<Mesh *>(ob)->getMeshFileName());
+      if (auto *sob = dynamic_cast<SingleBodyObject *>(ob)) bytes += byteSize(sob->getAppearance());
+      reserveOutput(bytes);
       data_ = set(data_, ob->visualTag, initialized, ob->getObjectType(), false);
       if (ob->getObjectType() == ObjectType::ARTICULATED_SYSTEM) {
         auto as = dynamic_cast<ArticulatedSystem *>(ob);
@@ -1460,6 +2581,7 @@ class RaisimServer final {
         if (!initialized ) data_ = set(data_, ob->name_);
 
         for (auto &vob: dynamic_cast<Compound *>(ob)->getObjList()) {
+          reserveOutput(byteSize(vob.appearance));
           if (!initialized) {
             switch (vob.objectType) {
               case BOX:
@@ -1490,7 +2612,7 @@ class RaisimServer final {
           Vec<4> quat;
           raisim::rotMatToQuat(rot, quat);
           pos = pos + center;
-          data_ = setInFloat(data_, pos, quat);
+          setPose(pos, quat);
         }
         data_ = set(data_, (int32_t) 0);
       } else {
@@ -1526,7 +2648,7 @@ class RaisimServer final {
               data_ = set(data_, Shape::HeightMap);
               data_ = setInFloat(data_, hm->getCenterX(), hm->getCenterY(), hm->getXSize(), hm->getYSize());
               data_ = set(data_, (int32_t) hm->getXSamples(), (int32_t) hm->getYSamples());
-              data_ = setInFloat(data_, hm->getHeightVector());
+              setHeights(hm->getHeightVector());
               data_ = set(data_, hm->getColorMap());
             }
             case COMPOUND:
@@ -1544,14 +2666,7 @@ class RaisimServer final {
 
         // if heightmap, check if update is necessary
         if (ob->getObjectType() == ObjectType::HEIGHTMAP) {
-          auto hm = dynamic_cast<HeightMap *>(ob);
-          data_ = set(data_, int(hm->isUpdated()));
-          if (hm->isUpdated()) {
-            data_ = setInFloat(data_, hm->getCenterX(), hm->getCenterY(), hm->getXSize(), hm->getYSize());
-            data_ = set(data_, (int32_t) hm->getXSamples(), (int32_t) hm->getYSamples());
-            data_ = setInFloat(data_, hm->getHeightVector());
-            data_ = set(data_, hm->getColorMap());
-          }
+          serializeHeightMapUpdate(dynamic_cast<HeightMap *>(ob), initialized);
         } else if (ob->getObjectType() == ObjectType::MESH)
           data_ = set(data_, int(false));
 
@@ -1601,7 +2716,7 @@ class RaisimServer final {
         Vec<4> quat;
         sob->getPosition(pos);
         sob->getQuaternion(quat);
-        data_ = setInFloat(data_, pos, quat);
+        setPose(pos, quat);
         data_ = set(data_, (int32_t) 0);
       }
       ob->unlockMutex();
@@ -1611,9 +2726,16 @@ class RaisimServer final {
       sw->lockMutex();
       bool initialized = sw->visualTag != 0;
       if (!initialized) sw->visualTag = visTagCounter++;
+      if (deltaEncoding_ && isUnchangedSinceLastSent(sw.get(), initialized)) {
+        sw->unlockMutex();
+        continue;
+      }
+      objectSize++;
+      const std::string color = colorToString(sw->getColor());
+      reserveOutput(byteSize(sw->name_) + byteSize(color));
       data_ = set(data_, sw->visualTag, initialized, int32_t(-1), false, (int32_t)1);
       if (!initialized) data_ = set(data_, sw->name_, Shape::SingleLine, Masking::CONSTRAINTS, int32_t(0));
-      data_ = set(data_, colorToString(sw->getColor()));
+      data_ = set(data_, color);
       Vec<3> pos, diff, diff_norm;
       Vec<4> quat;
       Mat<3,3> rot;
@@ -1623,7 +2745,7 @@ class RaisimServer final {
       raisim::zaxisToRotMat(diff_norm, rot);
       raisim::rotMatToQuat(rot, quat);
       data_ = set(data_, float(sw->getVisualizationWidth()), float(sw->getVisualizationWidth()), (float)diff.norm(), 0.f);
-      data_ = setInFloat(data_, pos, quat);
+      setPose(pos, quat);
       data_ = set(data_, (int32_t) 0);
       sw->unlockMutex();
     }
@@ -1634,6 +2756,19 @@ class RaisimServer final {
       vo->lockMutex();
       bool initialized = vo->visualTag != 0;
       if (!initialized) vo->visualTag = visTagCounter++;
+      if (deltaEncoding_ && isUnchangedSinceLastSent(vo, initialized)) {
+        vo->unlockMutex();
+        continue;
+      }
+      objectSize++;
+      const std::string color = colorToString(vo->color);
+      size_t bytes = byteSize(vo->name) + byteSize(color);
+      if (vo->type == Shape::Mesh) {
+        auto vm = reinterpret_cast<VisualMesh *>(vo);
+        bytes += 2 * (byteSize(vm->vertexArray_) + byteSize(vm->colorArray_)) + byteSize(vm->indexArray_) +
+            byteSize(vm->meshFileName_);
+      }
+      reserveOutput(bytes);
       Vec<3> pos = vo->getPosition();
       Vec<4> quat = vo->getOrientation();
       data_ = set(data_, vo->visualTag, initialized, int32_t(-1), false, int32_t(1));
@@ -1657,8 +2792,9 @@ class RaisimServer final {
           data_ = set(data_, vm->vertexArray_, vm->colorArray_);
       }
 
-      data_ = set(data_, colorToString(vo->color));
-      data_ = setInFloat(data_, vo->size, pos, quat);
+      data_ = set(data_, color);
+      data_ = setInFloat(data_, vo->size);
+      setPose(pos, quat);
       data_ = set(data_, (int32_t) 0);
       vo->unlockMutex();
     }
@@ -1669,6 +2805,12 @@ class RaisimServer final {
       auto *ob = &vis.second->obj;
       bool initialized = ob->visualTag != 0;
       if (!initialized) ob->visualTag = visTagCounter++;
+      if (deltaEncoding_ && isUnchangedSinceLastSent(vis.second, initialized)) {
+        vis.second->unlockMutex();
+        continue;
+      }
+      objectSize++;
+      reserveOutput(0);
       data_ = set(data_, ob->visualTag, initialized, int32_t(-1), false);
       serializeAS(ob, initialized, vis.second->color);
       vis.second->unlockMutex();
@@ -1679,26 +2821,26 @@ class RaisimServer final {
       auto *hm = &vis.second->obj;
       bool initialized = hm->visualTag != 0;
       if (!initialized) hm->visualTag = visTagCounter++;
+      if (deltaEncoding_ && isUnchangedSinceLastSent(hm, initialized)) {
+        vis.second->unlockMutex();
+        continue;
+      }
+      objectSize++;
+      reserveOutput(2 * heightMapByteSize(hm) + byteSize(hm->getName()) + byteSize(hm->getAppearance()));
       data_ = set(data_, hm->visualTag, initialized, int32_t(-1), false, int32_t(1));
       if (!initialized) {
         data_ = set(data_, hm->getName(), Shape::HeightMap);
         data_ = setInFloat(data_, hm->getCenterX(), hm->getCenterY(), hm->getXSize(), hm->getYSize());
         data_ = set(data_, (int32_t) hm->getXSamples(), (int32_t) hm->getYSamples());
-        data_ = setInFloat(data_, hm->getHeightVector());
+        setHeights(hm->getHeightVector());
         data_ = set(data_, hm->getColorMap());
         data_ = set(data_, Masking::VIS_OBJ, int32_t(0));
       }
 
-      data_ = set(data_, int(hm->isUpdated()));
-      if (hm->isUpdated()) {
-        data_ = setInFloat(data_, hm->getCenterX(), hm->getCenterY(), hm->getXSize(), hm->getYSize());
-        data_ = set(data_, (int32_t) hm->getXSamples(), (int32_t) hm->getYSamples());
-        data_ = setInFloat(data_, hm->getHeightVector());
-        data_ = set(data_, hm->getColorMap());
-      }
+      serializeHeightMapUpdate(hm, initialized);
       data_ = set(data_, hm->getAppearance());
       data_ = set(data_, 0.f, 0.f, 0.f, 0.f);
-      data_ = setInFloat(data_, hm->getPosition(), hm->getQuaternion());
+      setPose(hm->getPosition(), hm->getQuaternion());
       data_ = set(data_, (int32_t) 0);
       vis.second->unlockMutex();
     }
@@ -1709,12 +2851,16 @@ class RaisimServer final {
       v->lockMutex();
       bool initialized = v->visualTag != 0;
       if (!initialized) v->visualTag = visTagCounter++;
+      if (deltaEncoding_) markAsSent(v->visualTag);
+      objectSize++;
+      reserveOutput(byteSize(v->name) + v->count() * (sizeof(float) + 10 * sizeof(float)));
       data_ = set(data_, v->visualTag, initialized, int32_t(-1), true, (int32_t) v->count());
       if (!initialized) data_ = set(data_, v->name, v->type, Masking::VIS_OBJ);
       data_ = setInFloat(data_, v->color1, v->color2);
       for (size_t i = 0; i < v->count(); i++) {
         data_ = set(data_, v->data[i].colorWeight);
-        data_ = setInFloat(data_, v->data[i].scale, v->data[i].pos, v->data[i].quat);
+        data_ = setInFloat(data_, v->data[i].scale);
+        setPose(v->data[i].pos, v->data[i].quat);
       }
       v->unlockMutex();
     }
@@ -1725,6 +2871,9 @@ class RaisimServer final {
       ptr->lockMutex();
       bool initialized = ptr->visualTag != 0;
       if (!initialized) ptr->visualTag = visTagCounter++;
+      if (deltaEncoding_) markAsSent(ptr->visualTag);
+      objectSize++;
+      reserveOutput(byteSize(ptr->name) + ptr->points.size() * 11 * sizeof(float));
       data_ = set(data_, ptr->visualTag, initialized, int32_t(-1), true, (int32_t) (ptr->points.size()-1));
       if (!initialized) data_ = set(data_, ptr->name, Shape::PolyLine, Masking::VIS_OBJ);
       data_ = setInFloat(data_, ptr->color, ptr->color);
@@ -1739,10 +2888,32 @@ class RaisimServer final {
         raisim::zaxisToRotMat(norm_diff, rot);
         raisim::rotMatToQuat(rot, quat);
         data_ = setInFloat(data_, 0., ptr->width, ptr->width, diff.norm());
-        data_ = setInFloat(data_, pos, quat);
+        setPose(pos, quat);
       }
       ptr->unlockMutex();
     }
+    set(objectSizeLocation, objectSize);
+
+    // objects which were sent before but do not exist anymore
+    if (deltaEncoding_) {
+      reserveOutput(sentState_.size() * sizeof(uint32_t));
+      auto removedSizeLocation = data_;
+      int32_t removedSize = 0;
+      data_ = set(data_, removedSize); // reserving space
+
+      if (sentState_.size() > deltaSeen_) {
+        for (auto it = sentState_.begin(); it != sentState_.end();) {
+          if (it->second.lastFrame != deltaFrame_) {
+            data_ = set(data_, it->first);
+            removedSize++;
+            it = sentState_.erase(it);
+          } else {
+            ++it;
+          }
+        }
+      }
+      set(removedSizeLocation, removedSize);
+    }
 
     // External forces
     int32_t numExtForce = 0;
@@ -1755,6 +2926,7 @@ class RaisimServer final {
       ob->unlockMutex();
     }
 
+    reserveOutput((numExtForce + numExtTorque) * 6 * sizeof(float));
     data_ = set(data_, numExtForce);
     for (auto *ob: world_->getObjList()) {
       ob->lockMutex();
@@ -1784,6 +2956,7 @@ class RaisimServer final {
     /// contact position
     for (auto *obj: world_->getObjList()) {
       obj->lockMutex();
+      reserveOutput(obj->getContacts().size() * 6 * sizeof(float));
 
       for (auto &contact: obj->getContacts()) {
         if (!contact.isObjectA() && contact.getPairObjectBodyType()==BodyType::DYNAMIC)
@@ -1813,15 +2986,14 @@ class RaisimServer final {
     data_ = set(data_, int32_t(pointClouds_.size()));
     for (auto& pc : pointClouds_) {
       if(pc.second->visualTag == 0) pc.second->visualTag = visTagCounter++;
+      reserveOutput(pc.second->position.size() * 7 * sizeof(float));
       data_ = pc.second->serialize(data_);    
     }
 
     // object information
-    auto found = std::find_if(world_->getObjList().begin(), world_->getObjList().end(),
-                              [this](const Object * ptr) { return ptr->visualTag == this->objectId_; });
+    auto obSelected = findObjectByVisualTag(objectId_);
 
-    if (found != world_->getObjList().end()) {
-      auto obSelected = *found;
+    if (obSelected) {
       obSelected->lockMutex();
       if (obSelected->getObjectType() == ObjectType::ARTICULATED_SYSTEM) {
         data_ = set(data_, int32_t(1));
@@ -1830,6 +3002,7 @@ class RaisimServer final {
         data_ = set(data_, int32_t(as->getDOF()));
         data_ = set(data_, int32_t(as->getMovableJointNames().size()));
         data_ = set(data_, int32_t(as->getFrames().size()));
+        reserveOutput((as->getGeneralizedCoordinateDim() + as->getDOF()) * sizeof(float));
 
         for (int i = 0; i < as->getGeneralizedCoordinateDim(); i++)
           data_ = set(data_, float(as->getGeneralizedCoordinate()[i]));
@@ -1838,6 +3011,7 @@ class RaisimServer final {
           data_ = set(data_, float(as->getGeneralizedVelocity()[i]));
 
         for (int i = 0; i < as->getMovableJointNames().size(); i++) {
+          reserveOutput(byteSize(as->getMovableJointNames()[i]));
           data_ = set(data_, as->getMovableJointNames()[i]);
           int j = i;
           if (as->getJointType(0) == Joint::Type::FIXED)
@@ -1855,6 +3029,7 @@ class RaisimServer final {
         Vec<4> quat;
         Mat<3, 3> rot;
         for (int i = 0; i < as->getFrames().size(); i++) {
+          reserveOutput(byteSize(as->getFrames()[i].name));
           data_ = set(data_, as->getFrames()[i].name);
           as->getFramePosition(i, pos);
           as->getFrameOrientation(i, rot);
@@ -1897,6 +3072,7 @@ class RaisimServer final {
       bool initialized = c.second->visualTag != 0;
       if (!initialized) c.second->visualTag = visTagCounter++;
 
+      reserveOutput((initialized ? 0 : c.second->getInitializationSize()) + c.second->getSerializedSize());
       data_ = set(data_, (int32_t) c.second->getType(), initialized, c.second->visualTag);
       if (!initialized)
         data_ = c.second->initialize(data_);
@@ -1904,6 +3080,7 @@ class RaisimServer final {
       data_ = c.second->serialize(data_);
       c.second->unlockMutex();
     }
+    buffer.finish(data_);
   }
 
   inline bool receiveData(int seconds) {
@@ -1928,28 +3105,89 @@ class RaisimServer final {
       totalReceivedDataSize += currentReceivedDataSize;
     }
 
+    receivedDataSize_ = totalDataSize;
+    return true;
+  }
+
+  /// send the header in send_buffer (up to dataEnd) followed by the segments of the body
+  inline bool sendData(const char *dataEnd, const server::SegmentedBuffer *body = nullptr) {
+    using namespace server;
+    auto headerSize = size_t(dataEnd - &send_buffer[0]);
+    size_t dataSize = headerSize + (body ? body->size() : 0);
+    RSFATAL_IF(dataSize > size_t(std::numeric_limits<int>::max()), "The frame is too large: " << dataSize << " bytes")
+    set(&send_buffer[0], int(dataSize));
+
+    segments_.assign(1, {&send_buffer[0], headerSize});
+    if (body)
+      segments_.insert(segments_.end(), body->getSegments().begin(), body->getSegments().end());
+
+    if ((clientCapabilities_ & CAPABILITY_ZLIB) && compressionLevel_ > 0 && dataSize > compressionThreshold_) {
+      compressFrame(segments_, compressedFrame_);
+      segments_.assign(1, {compressedFrame_.data(), compressedFrame_.size()});
+    }
+
+#if __linux__ || __APPLE__
+    iovecs_.clear();
+    for (auto &segment: segments_)
+      iovecs_.push_back({const_cast<char *>(segment.first), segment.second});
+
+    size_t first = 0;
+    while (first < iovecs_.size()) {
+      if (!waitForMessageToClient(1)) return false;
+      msghdr message{};
+      message.msg_iov = iovecs_.data() + first;
+      message.msg_iovlen = std::min(iovecs_.size() - first, size_t(IOV_MAX));
+      auto currentlySentBytes = sendmsg(client_, &message, 0);
+      if (currentlySentBytes == -1) return false;
+
+      // skip the segments sent completely and advance into the partially sent one
+      auto remaining = size_t(currentlySentBytes);
+      while (first < iovecs_.size() && remaining >= iovecs_[first].iov_len)
+        remaining -= iovecs_[first++].iov_len;
+      if (first < iovecs_.size()) {
+        iovecs_[first].iov_base = static_cast<char *>(iovecs_[first].iov_base) + remaining;
+        iovecs_[first].iov_len -= remaining;
+      }
+    }
     return true;
+#elif WIN32
+    for (auto &segment: segments_)
+      if (!sendBytes(segment.first, segment.second)) return false;
+    return true;
+#endif
   }
 
-  inline bool sendData() {
+  /// compress a frame, given as segments, whose first segment starts with the size and the version
+  inline void compressFrame(std::vector<std::pair<const char *, size_t>> segments, std::vector<char> &out) {
     using namespace server;
-    int dataSize = int(data_ - &send_buffer[0]);
-    int totalSentBytes = 0;
-    int currentlySentBytes = 0;
-    set(&send_buffer[0], dataSize);
+    segments.front().first += 2 * sizeof(int);
+    segments.front().second -= 2 * sizeof(int);
+    size_t uncompressedSize = 0;
+    for (auto &segment: segments) uncompressedSize += segment.second;
+
+    // the stream is owned by the server thread, which changes its level only between frames
+    compressor_.setLevel(std::max(compressionLevel_.load(std::memory_order_relaxed), 1));
+    out.resize(3 * sizeof(int));
+    compressor_.compress(segments, out, out.size());
+    set(out.data(), int(out.size()), int(version_ | CAPABILITY_ZLIB), int(uncompressedSize));
+  }
 
-    while (dataSize > totalSentBytes)
+#if WIN32
+  inline bool sendBytes(const char *bytes, size_t size) {
+    size_t totalSentBytes = 0;
+    while (size > totalSentBytes)
       if (waitForMessageToClient(1)) {
-        currentlySentBytes = send(client_, &send_buffer[0] + totalSentBytes, dataSize - totalSentBytes, 0);
-        totalSentBytes += currentlySentBytes;
+        int currentlySentBytes = send(client_, bytes + totalSentBytes, int(size - totalSentBytes), 0);
         if (currentlySentBytes == -1) return false;
+        totalSentBytes += currentlySentBytes;
       } else
         return false;
 
     return true;
   }
+#endif
 
-  inline bool updateSensorMeasurements() {
+  inline bool updateSensorMeasurements(double updateTime) {
     using namespace server;
     world_->lockMutex();
     ClientMessageType cMsgType;
@@ -1958,26 +3196,15 @@ class RaisimServer final {
 
     if (cMsgType != ClientMessageType::REQUEST_SENSOR_UPDATE) return false;
 
-    auto &obList = world_->getObjList();
-
     for (int i = 0; i < nSensors; i++) {
       uint32_t visualTag;
       std::string name;
       Sensor::Type type;
       rData_ = get(rData_, &visualTag, &type, &name);
-      ArticulatedSystem *as = dynamic_cast<ArticulatedSystem*>(*std::find_if(obList.begin(), obList.end(),
-                                                                             [visualTag](const Object* i){ return i->visualTag == visualTag; }));
+      auto as = dynamic_cast<ArticulatedSystem*>(findObjectByVisualTag(visualTag));
+      RSFATAL_IF(!as, "Articulated system not found: " << visualTag)
       as->lockMutex();
-      Sensor* sensor = nullptr;
-      for (auto& sensorSet : as->getSensorSets()) {
-        for (auto& s : sensorSet->getSensors()) {
-          if (name == s->getFullName()) {
-            sensor = s;
-            break;
-          }
-        }
-        if (sensor) break;
-      }
+      Sensor* sensor = objectIndex_.findSensor(as, name);
 
       RSFATAL_IF(!sensor, "Sensor not found: " << name)
       sensor->lockMutex();
@@ -1988,14 +3215,14 @@ class RaisimServer final {
         auto &img = dynamic_cast<RGBCamera*>(sensor)->getImageBuffer();
         RSFATAL_IF(width * height * 4 != img.size(), "Image size mismatch. Sensor module not working properly")
         rData_ = getN(rData_, img.data(), width * height * 4);
-        sensor->setUpdateTimeStamp(sensorUpdateTime_);
+        sensor->setUpdateTimeStamp(updateTime);
       } else if (type == Sensor::Type::DEPTH) {
         int width, height;
         rData_ = get(rData_, &width, &height);
         auto &depthArray = dynamic_cast<DepthCamera*>(sensor)->getDepthArray();
         RSFATAL_IF(width * height != depthArray.size(), "Image size mismatch. Sensor module not working properly")
         rData_ = getN(rData_, depthArray.data(), width * height);
-        sensor->setUpdateTimeStamp(sensorUpdateTime_);
+        sensor->setUpdateTimeStamp(updateTime);
       }
       sensor->unlockMutex();
       as->unlockMutex();
@@ -2005,17 +3232,42 @@ class RaisimServer final {
   }
 
   char *data_, *rData_;
+  int receivedDataSize_ = 0;
   bool needsSensorUpdate_ = false;
   double sensorUpdateTime_;
   World *world_;
   std::vector<char> receive_buffer, send_buffer;
-  bool connected_ = false;
+  server::SegmentedBuffer output_, *outputBuffer_ = &output_;
+  std::vector<std::pair<const char *, size_t>> segments_;
+
+  // quantization
+  bool quantization_ = false, quantize_ = false;
+  double positionResolution_ = 1e-3;
+  Vec<3> quantizationOrigin_ = {0., 0., 0.}, originSum_ = {0., 0., 0.};
+  size_t originSamples_ = 0;
+  std::atomic<int> frameCapabilities_ = {0};
+
+  // compression
+  int clientCapabilities_ = 0;
+  std::atomic<int> compressionLevel_ = {1};
+  std::atomic<size_t> compressionThreshold_ = {65536};
+  server::FrameCompressor compressor_;
+  std::vector<char> compressedFrame_;
+#if __linux__ || __APPLE__
+  std::vector<iovec> iovecs_;
+#endif
+  std::atomic<bool> connected_ = {false};
   char tempBuffer[MAXIMUM_PACKET_SIZE];
   int state_ = STATUS_RENDERING;
+  std::mutex serverRequestMutex_;
   std::vector<ServerRequestType> serverRequest_;
-  Object* toBeFocused_;
+  Object* toBeFocused_ = nullptr;
   std::string videoName_;
-  uint32_t objectId_;
+  // the requests being serialized, taken from serverRequest_ by the server thread
+  std::vector<ServerRequestType> takenServerRequest_;
+  std::string takenVideoName_;
+  Eigen::Vector3d takenPosition_, takenLookAt_;
+  std::atomic<uint32_t> objectId_ = {0};
   std::atomic<bool> terminateRequested_ = {false};
   int client_;
   int server_fd_;
@@ -2040,6 +3292,49 @@ class RaisimServer final {
   // visual tag counter
   uint32_t visTagCounter = 30;
 
+  // snapshot mode
+  bool snapshotMode_ = false;
+  RenderSnapshot snapshots_[2];
+  int snapshotWriteIdx_ = 0;
+  std::atomic<RenderSnapshot *> publishedSnapshot_ = {nullptr};
+  std::mutex deferredRequestMutex_;
+  std::vector<std::pair<int, std::vector<char>>> deferredRequests_;
+
+  // visual tag, name and sensor lookup
+  ObjectIndex objectIndex_;
+
+  // shared-memory transport
+  Transport transport_ = Transport::TCP;
+  int sharedMemorySlots_ = 4;
+  size_t sharedMemorySlotCapacity_ = size_t(RECEIVE_BUFFER_SIZE);
+  int sharedMemoryPermissions_ = 0600;
+
+  // multiple clients and pipelining
+  int maxClients_ = 1;
+  bool pipelining_ = false;
+  std::map<int, ClientConnection> clients_;
+  uint64_t clientCounter_ = 0, frameCounter_ = 0, previousInitFrameId_ = 0;
+  std::shared_ptr<const SharedFrame> latestFrame_, lastInitFrame_;
+
+  // delta encoding
+  struct SentState {
+    std::vector<double> state;
+    std::string appearance;
+    uint64_t lastFrame = 0;
+  };
+
+  bool deltaEncoding_ = false, isKeyframe_ = true;
+  double deltaEpsilon_ = 1e-5;
+  int keyframeInterval_ = 100, framesSinceKeyframe_ = 0;
+  uint64_t deltaFrame_ = 0;
+  size_t deltaSeen_ = 0;
+  std::vector<double> deltaState_;
+  std::unordered_map<uint32_t, SentState> sentState_;
+
+  // heightmap regions
+  std::unordered_map<const Object *, HeightMapRegions> heightMapRegions_;
+  std::vector<double> regionHeights_;
+
   // hanging object
   uint32_t hangingObjVisTag_ = 0;
   Object* interactingOb_;
@@ -2084,6 +3379,19 @@ class RaisimServer final {
     charts_[title] = chart;
     return chart;
   }
+
+  /**
+    * Only works with RaisimUnreal. Creates a time series graph of the phase times, the contact count and the
+    * convergence of the contact solver, and connects it to the profiler. Every integrate(world, profiler) call adds a
+    * data point.
+    * @param[in] title title of the chart
+    * @param[in] profiler the profiler of the world
+    * @return pointer to the created Time Series Graph */
+  inline TimeSeriesGraph *addSolverProfilerGraph(const std::string &title, SolverProfiler &profiler) {
+    auto chart = addTimeSeriesGraph(title, SolverProfiler::getColumnNames(), "world time [s]", "");
+    profiler.setSink([chart](double time, const VecDyn &point) { chart->addDataPoints(time, point); });
+    return chart;
+  }
 };
 
 }  // namespace raisim
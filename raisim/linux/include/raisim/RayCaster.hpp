@@ -0,0 +1,893 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_RAYCASTER_HPP_
+#define RAISIM_INCLUDE_RAISIM_RAYCASTER_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include "ode/collision.h"
+#include "ode/collision_trimesh.h"
+#include "raisim/helper.hpp"
+#include "raisim/object/ArticulatedSystem/ArticulatedSystem.hpp"
+#include "raisim/object/singleBodies/Compound.hpp"
+#include "raisim/object/terrain/HeightMap.hpp"
+#include "raisim/ThreadPool.hpp"
+#include "raisim/World.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define RAISIM_RAYCASTER_AVX2 1
+#endif
+
+namespace raisim {
+
+/// rays of a RayCaster::cast call. The arrays are owned by the caller
+struct RayBatch {
+  /// the number of rays
+  size_t size = 0;
+  /// ray origins (x, y and z of each ray). If sharedOrigin is true, a single origin used by all rays
+  const double *origins = nullptr;
+  bool sharedOrigin = false;
+  /// unit ray directions (x, y and z of each ray)
+  const double *directions = nullptr;
+  /// the length of each ray. If nullptr, all rays have the same length, "length"
+  const double *lengths = nullptr;
+  double length = 100.;
+  /// an object ignored by all rays (e.g., the robot carrying the sensor)
+  const Object *exclude = nullptr;
+  /// if set, only this body of the excluded object is ignored (e.g., the body the sensor is attached to)
+  size_t excludeLocalIdx = size_t(-1);
+  /// collision bodies whose collision group is not in the mask are ignored
+  CollisionGroup collisionMask = CollisionGroup(-1);
+};
+
+/// closest hit of each ray, one array per field. Rays without a hit have an infinite distance and no object
+struct RayHits {
+  template<typename T>
+  using Array = std::vector<T, AlignedAllocator<T, 32>>;
+
+  void resize(size_t n) {
+    for (auto array: {&distance, &x, &y, &z, &normalX, &normalY, &normalZ}) array->resize(n);
+    object.resize(n);
+    localIndex.resize(n);
+  }
+
+  [[nodiscard]] size_t size() const { return distance.size(); }
+
+  Array<double> distance, x, y, z, normalX, normalY, normalZ;
+  std::vector<const Object *> object;
+  std::vector<size_t> localIndex;
+};
+
+/**
+ * Casts batches of rays against the collision bodies of a world (see World::rayTestBatch).
+ * update() gathers the collision geometry (primitives, meshes, heightmaps and the collision bodies of articulated
+ * systems) and rebuilds a bounding volume hierarchy over their bounds. Meshes get their own hierarchy in the local
+ * frame, which is cached as long as the mesh is found in every update() call. Heightmaps are traversed cell by cell with bounds of 8x8 cell blocks.
+ * cast() traverses packets of 4 rays (with AVX2 if the CPU supports it) and does not modify the caster, so it can be
+ * called from many threads between two update() calls. Geometry that is not supported directly (e.g., convex
+ * shapes) is tested with ODE.
+ * Only the closest hit of each ray is reported. A ray starting inside a primitive hits its surface on the way out. */
+class RayCaster {
+ public:
+  /**
+   * gather the collision geometry of the objects and rebuild the hierarchy. The collision bodies of the non-static
+   * objects are moved to the current poses of the objects
+   * @param[in] objects the objects of the world (World::getObjList()) */
+  void update(const std::vector<Object *> &objects) {
+    shapes_.clear();
+    unbounded_.clear();
+    heightFields_.clear();
+    for (auto &mesh: meshes_) mesh.seen = false;
+
+    for (auto ob: objects) {
+      if (ob->getObjectType() != HEIGHTMAP && ob->getBodyType() != BodyType::STATIC) ob->updateCollision();
+
+      switch (ob->getObjectType()) {
+        case ARTICULATED_SYSTEM:
+          for (auto &col: static_cast<ArticulatedSystem *>(ob)->getCollisionBodies())
+            addGeom(col.getCollisionObject(), ob, col.localIdx, col.getCollisionGroup());
+          break;
+
+        case HEIGHTMAP:
+          addHeightMap(static_cast<HeightMap *>(ob));
+          break;
+
+        case COMPOUND: {
+          auto compound = static_cast<Compound *>(ob);
+          for (auto geom: compound->getCollisionObjectList()) addGeom(geom, ob, 0, compound->getCollisionGroup());
+          break;
+        }
+
+        default:
+          if (isSingleBody(ob->getObjectType())) {
+            auto single = static_cast<SingleBodyObject *>(ob);
+            addGeom(single->getCollisionObject(), ob, 0, single->getCollisionGroup());
+          }
+      }
+    }
+
+    sweepMeshes();
+    std::vector<Bounds> bounds(shapes_.size());
+    for (size_t i = 0; i < shapes_.size(); i++) bounds[i] = shapes_[i].bounds;
+    buildHierarchy(bounds, 2, nodes_, shapeOrder_);
+  }
+
+  /**
+   * cast the rays. It can be called concurrently
+   * @param[in] rays the rays
+   * @param[out] hits the closest hit of each ray
+   * @param[in] pool threads sharing the packets. nullptr casts on the calling thread */
+  void cast(const RayBatch &rays, RayHits &hits, ThreadPool *pool = nullptr) const {
+    hits.resize(rays.size);
+    const size_t packets = (rays.size + PACKET - 1) / PACKET, tasks = (packets + PACKETS_PER_TASK - 1) / PACKETS_PER_TASK;
+    auto task = [&](size_t t) {
+      for (size_t p = t * PACKETS_PER_TASK; p < std::min(packets, (t + 1) * PACKETS_PER_TASK); p++)
+        castPacket(rays, p * PACKET, hits);
+    };
+
+    if (pool)
+      pool->parallelFor(tasks, task);
+    else
+      for (size_t t = 0; t < tasks; t++) task(t);
+  }
+
+  /// @return the number of collision geoms gathered in the last update() call
+  [[nodiscard]] size_t getNumberOfShapes() const { return shapes_.size() + unbounded_.size() + heightFields_.size(); }
+
+ private:
+  static constexpr size_t PACKET = 4, PACKETS_PER_TASK = 16, HEIGHTMAP_BLOCK = 8;
+  static constexpr int STACK_SIZE = 64;
+
+  struct Bounds {
+    double lower[3], upper[3];
+  };
+
+  // a leaf if count > 0 (items [first, first + count)), otherwise the children are the next node and "first"
+  struct Node {
+    Bounds bounds;
+    int32_t first, count;
+  };
+
+  struct Shape {
+    int geomClass;
+    dGeomID geom;
+    Mat<3, 3> rot;
+    Vec<3> pos;
+    double param[4];
+    Bounds bounds;
+    const Object *object;
+    size_t localIdx;
+    CollisionGroup group;
+    int mesh;
+  };
+
+  struct Mesh {
+    dGeomID geom;
+    int triangles;
+    // the first triangle in the local frame. A different mesh at the address of a freed geom does not match it
+    Vec<3> first[3];
+    bool seen;
+    std::vector<Vec<3>> v0, e1, e2;
+    std::vector<Node> nodes;
+    std::vector<int32_t> order;
+  };
+
+  struct HeightField {
+    const Object *object;
+    CollisionGroup group;
+    const std::vector<double> *height;
+    size_t xSamples, ySamples, xBlocks, yBlocks;
+    double x0, y0, dx, dy;
+    Bounds bounds;
+    std::vector<double> blockMin, blockMax;
+  };
+
+  struct Ray {
+    double o[3], d[3], inv[3];
+  };
+
+  struct Hit {
+    double t;
+    double normal[3];
+    const Object *object = nullptr;
+    size_t localIdx = 0;
+  };
+
+  struct Packet {
+    alignas(32) double o[3][PACKET];
+    alignas(32) double inv[3][PACKET];
+    alignas(32) double tMax[PACKET];
+  };
+
+  void addGeom(dGeomID geom, const Object *ob, size_t localIdx, CollisionGroup group) {
+    if (!geom) return;
+    Shape shape;
+    shape.geomClass = dGeomGetClass(geom);
+    shape.geom = geom;
+    shape.object = ob;
+    shape.localIdx = localIdx;
+    shape.group = group;
+    shape.mesh = -1;
+
+    if (shape.geomClass == dPlaneClass) {
+      dVector4 plane;
+      dGeomPlaneGetParams(geom, plane);
+      for (int i = 0; i < 4; i++) shape.param[i] = plane[i];
+      unbounded_.push_back(shape);
+      return;
+    }
+
+    // the heightmaps are traversed with their height vector
+    if (shape.geomClass == dHeightfieldClass) return;
+
+    const dReal *p = dGeomGetPosition(geom), *r = dGeomGetRotation(geom);
+    for (size_t i = 0; i < 3; i++) {
+      shape.pos[i] = p[i];
+      for (size_t j = 0; j < 3; j++) shape.rot(i, j) = r[4 * i + j];
+    }
+
+    dReal aabb[6];
+    dGeomGetAABB(geom, aabb);
+    for (int i = 0; i < 3; i++) {
+      shape.bounds.lower[i] = aabb[2 * i];
+      shape.bounds.upper[i] = aabb[2 * i + 1];
+    }
+
+    switch (shape.geomClass) {
+      case dSphereClass:
+        shape.param[0] = dGeomSphereGetRadius(geom);
+        break;
+      case dBoxClass: {
+        dVector3 lengths;
+        dGeomBoxGetLengths(geom, lengths);
+        for (int i = 0; i < 3; i++) shape.param[i] = 0.5 * lengths[i];
+        break;
+      }
+      case dCapsuleClass:
+      case dCylinderClass: {
+        dReal radius, length;
+        if (shape.geomClass == dCapsuleClass)
+          dGeomCapsuleGetParams(geom, &radius, &length);
+        else
+          dGeomCylinderGetParams(geom, &radius, &length);
+        shape.param[0] = radius;
+        shape.param[1] = 0.5 * length;
+        break;
+      }
+      case dTriMeshClass:
+        shape.mesh = getMesh(shape);
+        break;
+      default:
+        break;
+    }
+
+    shapes_.push_back(shape);
+  }
+
+  void addHeightMap(HeightMap *map) {
+    HeightField field;
+    field.object = map;
+    field.group = map->getCollisionGroup();
+    field.height = &map->getHeightVector();
+    field.xSamples = map->getXSamples();
+    field.ySamples = map->getYSamples();
+    if (field.xSamples < 2 || field.ySamples < 2) return;
+    field.x0 = map->getCenterX() - 0.5 * map->getXSize();
+    field.y0 = map->getCenterY() - 0.5 * map->getYSize();
+    field.dx = map->getXSize() / double(field.xSamples - 1);
+    field.dy = map->getYSize() / double(field.ySamples - 1);
+    field.xBlocks = (field.xSamples - 2) / HEIGHTMAP_BLOCK + 1;
+    field.yBlocks = (field.ySamples - 2) / HEIGHTMAP_BLOCK + 1;
+    field.blockMin.assign(field.xBlocks * field.yBlocks, std::numeric_limits<double>::infinity());
+    field.blockMax.assign(field.xBlocks * field.yBlocks, -std::numeric_limits<double>::infinity());
+
+    // a vertex on a block border belongs to both blocks
+    auto &height = *field.height;
+    for (size_t j = 0; j < field.ySamples; j++) {
+      const size_t by0 = j == 0 ? 0 : (j - 1) / HEIGHTMAP_BLOCK, by1 = std::min(j / HEIGHTMAP_BLOCK, field.yBlocks - 1);
+      for (size_t i = 0; i < field.xSamples; i++) {
+        const size_t bx0 = i == 0 ? 0 : (i - 1) / HEIGHTMAP_BLOCK, bx1 = std::min(i / HEIGHTMAP_BLOCK, field.xBlocks - 1);
+        const double h = height[i + j * field.xSamples];
+        for (size_t by = by0; by <= by1; by++)
+          for (size_t bx = bx0; bx <= bx1; bx++) {
+            auto &lower = field.blockMin[bx + by * field.xBlocks], &upper = field.blockMax[bx + by * field.xBlocks];
+            lower = std::min(lower, h);
+            upper = std::max(upper, h);
+          }
+      }
+    }
+
+    field.bounds.lower[0] = field.x0;
+    field.bounds.lower[1] = field.y0;
+    field.bounds.upper[0] = field.x0 + map->getXSize();
+    field.bounds.upper[1] = field.y0 + map->getYSize();
+    field.bounds.lower[2] = *std::min_element(field.blockMin.begin(), field.blockMin.end());
+    field.bounds.upper[2] = *std::max_element(field.blockMax.begin(), field.blockMax.end());
+    heightFields_.push_back(std::move(field));
+  }
+
+  // the vertices of a triangle in the local frame of the geom
+  static void getLocalTriangle(const Shape &shape, int k, Vec<3> &v0, Vec<3> &v1, Vec<3> &v2) {
+    dVector3 world[3];
+    dGeomTriMeshGetTriangle(shape.geom, k, &world[0], &world[1], &world[2]);
+    Vec<3> *local[3] = {&v0, &v1, &v2};
+    for (int v = 0; v < 3; v++)
+      for (size_t i = 0; i < 3; i++) {
+        double value = 0.;
+        for (size_t j = 0; j < 3; j++) value += shape.rot(j, i) * (world[v][j] - shape.pos[j]);
+        (*local[v])[i] = value;
+      }
+  }
+
+  static bool isSameMesh(const Mesh &mesh, int triangles, const Vec<3> (&first)[3]) {
+    if (mesh.triangles != triangles) return false;
+    for (int v = 0; v < 3; v++)
+      for (size_t i = 0; i < 3; i++)
+        if (std::abs(mesh.first[v][i] - first[v][i]) > 1e-6) return false;
+    return true;
+  }
+
+  // the triangles are stored in the local frame of the geom, so that the hierarchy survives motion
+  int getMesh(const Shape &shape) {
+    const int triangles = dGeomTriMeshGetTriangleCount(shape.geom);
+    Vec<3> first[3];
+    for (auto &v: first) v.setZero();
+    if (triangles > 0) getLocalTriangle(shape, 0, first[0], first[1], first[2]);
+
+    auto found = meshIndex_.find(shape.geom);
+    if (found != meshIndex_.end() && isSameMesh(meshes_[found->second], triangles, first)) {
+      meshes_[found->second].seen = true;
+      return found->second;
+    }
+
+    Mesh mesh;
+    mesh.geom = shape.geom;
+    mesh.triangles = triangles;
+    for (int v = 0; v < 3; v++) mesh.first[v] = first[v];
+    mesh.seen = true;
+    std::vector<Bounds> bounds(triangles);
+    std::vector<Vec<3>> v0(triangles), v1(triangles), v2(triangles);
+
+    for (int k = 0; k < triangles; k++) {
+      getLocalTriangle(shape, k, v0[k], v1[k], v2[k]);
+      for (size_t i = 0; i < 3; i++) {
+        bounds[k].lower[i] = std::min({v0[k][i], v1[k][i], v2[k][i]});
+        bounds[k].upper[i] = std::max({v0[k][i], v1[k][i], v2[k][i]});
+      }
+    }
+
+    buildHierarchy(bounds, 4, mesh.nodes, mesh.order);
+    mesh.v0.resize(triangles);
+    mesh.e1.resize(triangles);
+    mesh.e2.resize(triangles);
+    for (int k = 0; k < triangles; k++) {
+      const int t = mesh.order[k];
+      mesh.v0[k] = v0[t];
+      vecsub(v1[t], v0[t], mesh.e1[k]);
+      vecsub(v2[t], v0[t], mesh.e2[k]);
+    }
+
+    const int index = found != meshIndex_.end() ? found->second : int(meshes_.size());
+    if (index == int(meshes_.size()))
+      meshes_.push_back(std::move(mesh));
+    else
+      meshes_[index] = std::move(mesh);
+    meshIndex_[shape.geom] = index;
+    return index;
+  }
+
+  // drop the hierarchies of the meshes that were not found in this update (i.e., removed from the world)
+  void sweepMeshes() {
+    if (std::all_of(meshes_.begin(), meshes_.end(), [](const Mesh &mesh) { return mesh.seen; })) return;
+    std::vector<int> index(meshes_.size(), -1);
+    size_t kept = 0;
+    for (size_t i = 0; i < meshes_.size(); i++) {
+      if (!meshes_[i].seen) continue;
+      index[i] = int(kept);
+      if (kept != i) meshes_[kept] = std::move(meshes_[i]);
+      kept++;
+    }
+    meshes_.resize(kept);
+    meshIndex_.clear();
+    for (size_t i = 0; i < kept; i++) meshIndex_[meshes_[i].geom] = int(i);
+    for (auto &shape: shapes_)
+      if (shape.mesh >= 0) shape.mesh = index[shape.mesh];
+  }
+
+  // median split along the longest axis of the centroids
+  static void buildHierarchy(const std::vector<Bounds> &bounds, int leafSize, std::vector<Node> &nodes,
+                             std::vector<int32_t> &order) {
+    nodes.clear();
+    order.resize(bounds.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = int32_t(i);
+    if (bounds.empty()) return;
+    nodes.reserve(2 * bounds.size());
+
+    struct Task {
+      int32_t node, begin, end;
+    };
+    std::vector<Task> tasks{{0, 0, int32_t(bounds.size())}};
+    nodes.emplace_back();
+
+    while (!tasks.empty()) {
+      Task task = tasks.back();
+      tasks.pop_back();
+      Bounds box, centroids;
+      for (int i = 0; i < 3; i++) {
+        box.lower[i] = centroids.lower[i] = std::numeric_limits<double>::infinity();
+        box.upper[i] = centroids.upper[i] = -std::numeric_limits<double>::infinity();
+      }
+      for (int32_t k = task.begin; k < task.end; k++) {
+        auto &item = bounds[order[k]];
+        for (int i = 0; i < 3; i++) {
+          const double centroid = 0.5 * (item.lower[i] + item.upper[i]);
+          box.lower[i] = std::min(box.lower[i], item.lower[i]);
+          box.upper[i] = std::max(box.upper[i], item.upper[i]);
+          centroids.lower[i] = std::min(centroids.lower[i], centroid);
+          centroids.upper[i] = std::max(centroids.upper[i], centroid);
+        }
+      }
+      nodes[task.node].bounds = box;
+
+      if (task.end - task.begin <= leafSize) {
+        nodes[task.node].first = task.begin;
+        nodes[task.node].count = task.end - task.begin;
+        continue;
+      }
+
+      int axis = 0;
+      for (int i = 1; i < 3; i++)
+        if (centroids.upper[i] - centroids.lower[i] > centroids.upper[axis] - centroids.lower[axis]) axis = i;
+      const int32_t middle = (task.begin + task.end) / 2;
+      std::nth_element(order.begin() + task.begin, order.begin() + middle, order.begin() + task.end,
+                       [&bounds, axis](int32_t a, int32_t b) {
+                         return bounds[a].lower[axis] + bounds[a].upper[axis] < bounds[b].lower[axis] + bounds[b].upper[axis];
+                       });
+
+      const int32_t left = int32_t(nodes.size()), right = left + 1;
+      nodes.emplace_back();
+      nodes.emplace_back();
+      nodes[task.node].first = left;
+      nodes[task.node].count = 0;
+      tasks.push_back({right, middle, task.end});
+      tasks.push_back({left, task.begin, middle});
+    }
+  }
+
+  void castPacket(const RayBatch &rays, size_t begin, RayHits &hits) const {
+    Packet packet;
+    Ray ray[PACKET];
+    Hit hit[PACKET];
+
+    for (size_t lane = 0; lane < PACKET; lane++) {
+      const size_t i = begin + lane;
+      if (i >= rays.size) {
+        for (int a = 0; a < 3; a++) packet.o[a][lane] = packet.inv[a][lane] = 0.;
+        packet.tMax[lane] = -1.;
+        continue;
+      }
+      const double *origin = rays.sharedOrigin ? rays.origins : rays.origins + 3 * i;
+      for (int a = 0; a < 3; a++) {
+        ray[lane].o[a] = packet.o[a][lane] = origin[a];
+        ray[lane].d[a] = rays.directions[3 * i + a];
+        ray[lane].inv[a] = packet.inv[a][lane] = 1. / ray[lane].d[a];
+      }
+      packet.tMax[lane] = hit[lane].t = rays.lengths ? rays.lengths[i] : rays.length;
+    }
+
+    auto active = [&](const Object *ob, size_t localIdx, CollisionGroup group) {
+      const bool excluded = ob == rays.exclude && (rays.excludeLocalIdx == size_t(-1) || rays.excludeLocalIdx == localIdx);
+      return !excluded && (group & rays.collisionMask);
+    };
+
+    for (size_t lane = 0; lane < PACKET; lane++) {
+      if (packet.tMax[lane] < 0.) continue;
+      for (auto &shape: unbounded_)
+        if (active(shape.object, shape.localIdx, shape.group)) intersectShape(shape, ray[lane], hit[lane]);
+      for (auto &field: heightFields_)
+        if (active(field.object, 0, field.group)) intersectHeightField(field, ray[lane], hit[lane]);
+      packet.tMax[lane] = hit[lane].t;
+    }
+
+    if (!nodes_.empty()) {
+      int32_t stack[STACK_SIZE];
+      int top = 0;
+      stack[top++] = 0;
+      while (top) {
+        const Node &node = nodes_[stack[--top]];
+        const int mask = testPacket(node.bounds, packet);
+        if (!mask) continue;
+
+        if (node.count == 0) {
+          stack[top++] = node.first + 1;
+          stack[top++] = node.first;
+          continue;
+        }
+
+        for (int32_t k = node.first; k < node.first + node.count; k++) {
+          auto &shape = shapes_[shapeOrder_[k]];
+          if (!active(shape.object, shape.localIdx, shape.group)) continue;
+          for (size_t lane = 0; lane < PACKET; lane++)
+            if (mask & (1 << lane) && intersectShape(shape, ray[lane], hit[lane])) packet.tMax[lane] = hit[lane].t;
+        }
+      }
+    }
+
+    for (size_t lane = 0; lane < PACKET && begin + lane < rays.size; lane++) {
+      const size_t i = begin + lane;
+      auto &result = hit[lane];
+      hits.object[i] = result.object;
+      hits.localIndex[i] = result.localIdx;
+      if (!result.object) {
+        hits.distance[i] = std::numeric_limits<double>::infinity();
+        hits.x[i] = hits.y[i] = hits.z[i] = hits.normalX[i] = hits.normalY[i] = hits.normalZ[i] = 0.;
+        continue;
+      }
+      hits.distance[i] = result.t;
+      hits.x[i] = ray[lane].o[0] + result.t * ray[lane].d[0];
+      hits.y[i] = ray[lane].o[1] + result.t * ray[lane].d[1];
+      hits.z[i] = ray[lane].o[2] + result.t * ray[lane].d[2];
+      hits.normalX[i] = result.normal[0];
+      hits.normalY[i] = result.normal[1];
+      hits.normalZ[i] = result.normal[2];
+    }
+  }
+
+  // @return a bit per lane whose ray overlaps the box before its current closest hit
+  static int testPacket(const Bounds &box, const Packet &packet) {
+#ifdef RAISIM_RAYCASTER_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) return testPacketAvx2(box, packet);
+#endif
+    int mask = 0;
+    for (size_t lane = 0; lane < PACKET; lane++) {
+      double t0 = 0., t1 = packet.tMax[lane];
+      for (int a = 0; a < 3; a++) {
+        const double lower = (box.lower[a] - packet.o[a][lane]) * packet.inv[a][lane];
+        const double upper = (box.upper[a] - packet.o[a][lane]) * packet.inv[a][lane];
+        t0 = std::max(t0, std::min(lower, upper));
+        t1 = std::min(t1, std::max(lower, upper));
+      }
+      if (t0 <= t1) mask |= 1 << lane;
+    }
+    return mask;
+  }
+
+#ifdef RAISIM_RAYCASTER_AVX2
+  __attribute__((target("avx2"))) static int testPacketAvx2(const Bounds &box, const Packet &packet) {
+    __m256d t0 = _mm256_setzero_pd(), t1 = _mm256_load_pd(packet.tMax);
+    for (int a = 0; a < 3; a++) {
+      const __m256d origin = _mm256_load_pd(packet.o[a]), inv = _mm256_load_pd(packet.inv[a]);
+      const __m256d lower = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(box.lower[a]), origin), inv);
+      const __m256d upper = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(box.upper[a]), origin), inv);
+      t0 = _mm256_max_pd(t0, _mm256_min_pd(lower, upper));
+      t1 = _mm256_min_pd(t1, _mm256_max_pd(lower, upper));
+    }
+    return _mm256_movemask_pd(_mm256_cmp_pd(t0, t1, _CMP_LE_OQ));
+  }
+#endif
+
+  static bool testRay(const Bounds &box, const Ray &ray, double tMax) {
+    double t0 = 0., t1 = tMax;
+    for (int a = 0; a < 3; a++) {
+      const double lower = (box.lower[a] - ray.o[a]) * ray.inv[a], upper = (box.upper[a] - ray.o[a]) * ray.inv[a];
+      t0 = std::max(t0, std::min(lower, upper));
+      t1 = std::min(t1, std::max(lower, upper));
+    }
+    return t0 <= t1;
+  }
+
+  // the closest t >= 0 of a*t^2 + 2*b*t + c = 0 within the accepted range
+  template<typename Accept>
+  static bool solveQuadratic(double a, double b, double c, double &t, Accept accept) {
+    const double discriminant = b * b - a * c;
+    if (a < 1e-12 || discriminant < 0.) return false;
+    const double root = std::sqrt(discriminant);
+    for (double candidate: {(-b - root) / a, (-b + root) / a})
+      if (candidate >= 0. && candidate < t && accept(candidate)) {
+        t = candidate;
+        return true;
+      }
+    return false;
+  }
+
+  bool intersectShape(const Shape &shape, const Ray &ray, Hit &hit) const {
+    double t = hit.t, normal[3] = {0., 0., 0.};
+
+    if (shape.geomClass == dPlaneClass) {
+      const double denominator = shape.param[0] * ray.d[0] + shape.param[1] * ray.d[1] + shape.param[2] * ray.d[2];
+      const double distance = shape.param[0] * ray.o[0] + shape.param[1] * ray.o[1] + shape.param[2] * ray.o[2] - shape.param[3];
+      if (std::abs(denominator) < 1e-12 || -distance / denominator < 0. || -distance / denominator >= t) return false;
+      hit.t = -distance / denominator;
+      for (int i = 0; i < 3; i++) hit.normal[i] = shape.param[i];
+      hit.object = shape.object;
+      hit.localIdx = shape.localIdx;
+      return true;
+    }
+
+    // the ray in the frame of the geom
+    double o[3], d[3];
+    for (int i = 0; i < 3; i++) {
+      o[i] = d[i] = 0.;
+      for (int j = 0; j < 3; j++) {
+        o[i] += shape.rot(j, i) * (ray.o[j] - shape.pos[j]);
+        d[i] += shape.rot(j, i) * ray.d[j];
+      }
+    }
+
+    auto point = [&](double s, int i) { return o[i] + s * d[i]; };
+    bool found = false;
+
+    switch (shape.geomClass) {
+      case dSphereClass: {
+        const double r = shape.param[0];
+        found = solveQuadratic(d[0] * d[0] + d[1] * d[1] + d[2] * d[2], o[0] * d[0] + o[1] * d[1] + o[2] * d[2],
+                               o[0] * o[0] + o[1] * o[1] + o[2] * o[2] - r * r, t, [](double) { return true; });
+        if (found)
+          for (int i = 0; i < 3; i++) normal[i] = point(t, i) / r;
+        break;
+      }
+
+      case dBoxClass: {
+        double t0 = -std::numeric_limits<double>::infinity(), t1 = std::numeric_limits<double>::infinity();
+        int axis0 = 0, axis1 = 0;
+        for (int i = 0; i < 3; i++) {
+          const double inv = 1. / d[i];
+          double lower = (-shape.param[i] - o[i]) * inv, upper = (shape.param[i] - o[i]) * inv;
+          if (lower > upper) std::swap(lower, upper);
+          if (lower > t0) {
+            t0 = lower;
+            axis0 = i;
+          }
+          if (upper < t1) {
+            t1 = upper;
+            axis1 = i;
+          }
+        }
+        if (t0 > t1 || t1 < 0.) break;
+        const int axis = t0 >= 0. ? axis0 : axis1;
+        const double candidate = t0 >= 0. ? t0 : t1;
+        if (candidate >= t) break;
+        t = candidate;
+        normal[axis] = point(t, axis) > 0. ? 1. : -1.;
+        found = true;
+        break;
+      }
+
+      case dCapsuleClass:
+      case dCylinderClass: {
+        const double r = shape.param[0], h = shape.param[1];
+        // side
+        if (solveQuadratic(d[0] * d[0] + d[1] * d[1], o[0] * d[0] + o[1] * d[1], o[0] * o[0] + o[1] * o[1] - r * r, t,
+                           [&](double s) { return std::abs(point(s, 2)) <= h; })) {
+          found = true;
+          normal[0] = point(t, 0) / r;
+          normal[1] = point(t, 1) / r;
+          normal[2] = 0.;
+        }
+        for (double side: {-1., 1.}) {
+          if (shape.geomClass == dCylinderClass) {
+            const double s = (side * h - o[2]) / d[2];
+            if (s >= 0. && s < t && point(s, 0) * point(s, 0) + point(s, 1) * point(s, 1) <= r * r) {
+              t = s;
+              found = true;
+              normal[0] = normal[1] = 0.;
+              normal[2] = side;
+            }
+          } else {
+            const double oz = o[2] - side * h;
+            if (solveQuadratic(d[0] * d[0] + d[1] * d[1] + d[2] * d[2], o[0] * d[0] + o[1] * d[1] + oz * d[2],
+                               o[0] * o[0] + o[1] * o[1] + oz * oz - r * r, t,
+                               [&](double s) { return side * point(s, 2) >= h; })) {
+              found = true;
+              normal[0] = point(t, 0) / r;
+              normal[1] = point(t, 1) / r;
+              normal[2] = (point(t, 2) - side * h) / r;
+            }
+          }
+        }
+        break;
+      }
+
+      case dTriMeshClass:
+        found = intersectMesh(meshes_[shape.mesh], o, d, t, normal);
+        break;
+
+      default:
+        return intersectOde(shape, ray, hit);
+    }
+
+    if (!found) return false;
+    hit.t = t;
+    for (int i = 0; i < 3; i++)
+      hit.normal[i] = shape.rot(i, 0) * normal[0] + shape.rot(i, 1) * normal[1] + shape.rot(i, 2) * normal[2];
+    hit.object = shape.object;
+    hit.localIdx = shape.localIdx;
+    return true;
+  }
+
+  // Moeller-Trumbore, both sides. The normal faces the ray
+  static bool intersectTriangle(const Vec<3> &v0, const Vec<3> &e1, const Vec<3> &e2, const double *o, const double *d,
+                                double &t, double *normal) {
+    const double p[3] = {d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]};
+    const double determinant = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (std::abs(determinant) < 1e-14) return false;
+    const double inv = 1. / determinant;
+    const double s[3] = {o[0] - v0[0], o[1] - v0[1], o[2] - v0[2]};
+    const double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv;
+    if (u < 0. || u > 1.) return false;
+    const double q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+    const double v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inv;
+    if (v < 0. || u + v > 1.) return false;
+    const double distance = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+    if (distance < 0. || distance >= t) return false;
+
+    t = distance;
+    double n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+    double scale = 1. / std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (n[0] * d[0] + n[1] * d[1] + n[2] * d[2] > 0.) scale = -scale;
+    for (int i = 0; i < 3; i++) normal[i] = n[i] * scale;
+    return true;
+  }
+
+  static bool intersectMesh(const Mesh &mesh, const double *o, const double *d, double &t, double *normal) {
+    if (mesh.nodes.empty()) return false;
+    Ray ray;
+    for (int i = 0; i < 3; i++) {
+      ray.o[i] = o[i];
+      ray.d[i] = d[i];
+      ray.inv[i] = 1. / d[i];
+    }
+
+    bool found = false;
+    int32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top) {
+      const Node &node = mesh.nodes[stack[--top]];
+      if (!testRay(node.bounds, ray, t)) continue;
+      if (node.count == 0) {
+        stack[top++] = node.first + 1;
+        stack[top++] = node.first;
+        continue;
+      }
+      for (int32_t k = node.first; k < node.first + node.count; k++)
+        found |= intersectTriangle(mesh.v0[k], mesh.e1[k], mesh.e2[k], o, d, t, normal);
+    }
+    return found;
+  }
+
+  // 2D DDA over a grid of cells. fn(ix, iy, tEnter, tExit) returns true to stop
+  template<typename Function>
+  static bool traverseGrid(double x0, double y0, double width, double height, size_t nx, size_t ny, const Ray &ray,
+                           double tStart, double tEnd, Function fn) {
+    const double px = ray.o[0] + tStart * ray.d[0], py = ray.o[1] + tStart * ray.d[1];
+    long ix = std::min(std::max(long(std::floor((px - x0) / width)), 0L), long(nx) - 1);
+    long iy = std::min(std::max(long(std::floor((py - y0) / height)), 0L), long(ny) - 1);
+    const long stepX = ray.d[0] > 0. ? 1 : -1, stepY = ray.d[1] > 0. ? 1 : -1;
+    const double infinity = std::numeric_limits<double>::infinity();
+    double tMaxX = ray.d[0] != 0. ? (x0 + double(ix + (stepX > 0)) * width - ray.o[0]) * ray.inv[0] : infinity;
+    double tMaxY = ray.d[1] != 0. ? (y0 + double(iy + (stepY > 0)) * height - ray.o[1]) * ray.inv[1] : infinity;
+    const double tDeltaX = ray.d[0] != 0. ? width * std::abs(ray.inv[0]) : infinity;
+    const double tDeltaY = ray.d[1] != 0. ? height * std::abs(ray.inv[1]) : infinity;
+    double t = tStart;
+
+    while (true) {
+      const double tNext = std::min({tMaxX, tMaxY, tEnd});
+      if (fn(size_t(ix), size_t(iy), t, tNext)) return true;
+      if (tNext >= tEnd) return false;
+      if (tMaxX < tMaxY) {
+        ix += stepX;
+        t = tMaxX;
+        tMaxX += tDeltaX;
+      } else {
+        iy += stepY;
+        t = tMaxY;
+        tMaxY += tDeltaY;
+      }
+      if (ix < 0 || iy < 0 || ix >= long(nx) || iy >= long(ny)) return false;
+    }
+  }
+
+  // the cells are split along the diagonal from (i, j) to (i + 1, j + 1), like HeightMap::getHeight
+  static bool intersectHeightField(const HeightField &field, const Ray &ray, Hit &hit) {
+    // the bounds are padded, so that flat terrain has a nonzero thickness
+    constexpr double PADDING = 1e-9;
+    double t0 = 0., t1 = hit.t;
+    for (int a = 0; a < 3; a++) {
+      const double lower = (field.bounds.lower[a] - PADDING - ray.o[a]) * ray.inv[a];
+      const double upper = (field.bounds.upper[a] + PADDING - ray.o[a]) * ray.inv[a];
+      t0 = std::max(t0, std::min(lower, upper));
+      t1 = std::min(t1, std::max(lower, upper));
+    }
+    if (!(t0 <= t1)) return false;
+
+    const auto &h = *field.height;
+    const size_t cellsX = field.xSamples - 1, cellsY = field.ySamples - 1;
+    const double blockWidth = field.dx * HEIGHTMAP_BLOCK, blockHeight = field.dy * HEIGHTMAP_BLOCK;
+    double normal[3];
+    double t = hit.t;
+
+    auto cell = [&](size_t i, size_t j, double tEnter, double tExit) {
+      Vec<3> p00, p10, p01, p11, e1, e2;
+      p00 = {field.x0 + double(i) * field.dx, field.y0 + double(j) * field.dy, h[i + j * field.xSamples]};
+      p10 = {p00[0] + field.dx, p00[1], h[i + 1 + j * field.xSamples]};
+      p01 = {p00[0], p00[1] + field.dy, h[i + (j + 1) * field.xSamples]};
+      p11 = {p00[0] + field.dx, p00[1] + field.dy, h[i + 1 + (j + 1) * field.xSamples]};
+      const double limit = std::min(t, tExit + 1e-9);
+      double candidate = limit;
+      bool found = false;
+      vecsub(p10, p00, e1);
+      vecsub(p11, p00, e2);
+      found |= intersectTriangle(p00, e1, e2, ray.o, ray.d, candidate, normal);
+      vecsub(p11, p00, e1);
+      vecsub(p01, p00, e2);
+      found |= intersectTriangle(p00, e1, e2, ray.o, ray.d, candidate, normal);
+      if (found && candidate >= tEnter - 1e-9) {
+        t = candidate;
+        return true;
+      }
+      return false;
+    };
+
+    auto block = [&](size_t bx, size_t by, double tEnter, double tExit) {
+      const double z0 = ray.o[2] + tEnter * ray.d[2], z1 = ray.o[2] + tExit * ray.d[2];
+      const size_t index = bx + by * field.xBlocks;
+      if (std::min(z0, z1) > field.blockMax[index] + PADDING || std::max(z0, z1) < field.blockMin[index] - PADDING)
+        return false;
+      return traverseGrid(field.x0, field.y0, field.dx, field.dy, cellsX, cellsY, ray, tEnter, tExit, cell);
+    };
+
+    if (!traverseGrid(field.x0, field.y0, blockWidth, blockHeight, field.xBlocks, field.yBlocks, ray, t0, t1, block))
+      return false;
+
+    // the terrain faces upwards, like HeightMap::getNormal
+    const double sign = normal[2] < 0. ? -1. : 1.;
+    hit.t = t;
+    for (int i = 0; i < 3; i++) hit.normal[i] = sign * normal[i];
+    hit.object = field.object;
+    hit.localIdx = 0;
+    return true;
+  }
+
+  // other geoms are tested with an ODE ray of the calling thread
+  static bool intersectOde(const Shape &shape, const Ray &ray, Hit &hit) {
+    thread_local dGeomID odeRay = nullptr;
+    if (!odeRay) {
+      odeRay = dCreateRay(nullptr, 1.);
+      dGeomRaySetClosestHit(odeRay, 1);
+    }
+    dGeomRaySet(odeRay, ray.o[0], ray.o[1], ray.o[2], ray.d[0], ray.d[1], ray.d[2]);
+    dGeomRaySetLength(odeRay, hit.t);
+    dContactGeom contact;
+    if (dCollide(odeRay, shape.geom, 1, &contact, sizeof(dContactGeom)) < 1 || contact.depth >= hit.t) return false;
+    hit.t = contact.depth;
+    for (int i = 0; i < 3; i++) hit.normal[i] = contact.normal[i];
+    hit.object = shape.object;
+    hit.localIdx = shape.localIdx;
+    return true;
+  }
+
+  std::vector<Shape> shapes_, unbounded_;
+  std::vector<HeightField> heightFields_;
+  std::vector<Node> nodes_;
+  std::vector<int32_t> shapeOrder_;
+  std::vector<Mesh> meshes_;
+  std::unordered_map<dGeomID, int> meshIndex_;
+};
+
+inline void World::rayTestBatch(RayCaster &caster, const RayBatch &rays, RayHits &hits, ThreadPool *pool) {
+  caster.update(getObjList());
+  caster.cast(rays, hits, pool);
+}
+
+}
+
+#endif // RAISIM_INCLUDE_RAISIM_RAYCASTER_HPP_
@@ -0,0 +1,190 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_SOLVERPROFILER_HPP_
+#define RAISIM_INCLUDE_RAISIM_SOLVERPROFILER_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "raisim/math.hpp"
+#include "raisim/World.hpp"
+
+namespace raisim {
+
+/**
+ * Records the cost of each integrate(World&, SolverProfiler&) call in a ring buffer: the time of each phase, the number of
+ * contact problems, the iterations of the contact solver and its final error.
+ * The phase timers are compiled out unless RAISIM_SOLVER_PROFILING is defined (the times are then 0). The counters are
+ * always recorded because they are read from the solver after the step.
+ * RaisimServer::addSolverProfilerGraph streams the samples to a TimeSeriesGraph. */
+class SolverProfiler {
+ public:
+  enum Phase : int {
+    /// World::integrate1: collision detection and contact registration
+    COLLISION_DETECTION = 0,
+    /// World::integrate2: contact problem assembly, contact solver and integration of the objects
+    SOLVER_AND_INTEGRATION,
+    PHASE_NUM
+  };
+
+  struct Sample {
+    double worldTime = 0.;
+    /// seconds spent in each phase
+    double phaseTime[PHASE_NUM] = {};
+    size_t contacts = 0;
+    int iterations = 0;
+    double error = 0.;
+
+    [[nodiscard]] double getTotalTime() const {
+      double total = 0.;
+      for (double time: phaseTime) total += time;
+      return total;
+    }
+  };
+
+  /// measures its lifetime and adds it to a phase of the current sample
+  class Scope {
+   public:
+#ifdef RAISIM_SOLVER_PROFILING
+    Scope(SolverProfiler &profiler, Phase phase)
+        : time_(profiler.current().phaseTime[phase]), start_(std::chrono::steady_clock::now()) {}
+
+    ~Scope() { time_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count(); }
+
+   private:
+    double &time_;
+    std::chrono::steady_clock::time_point start_;
+#else
+    Scope(SolverProfiler &, Phase) {}
+#endif
+  };
+
+  /**
+   * @param[in] capacity the number of samples kept. Older samples are overwritten */
+  explicit SolverProfiler(size_t capacity = 1000) : samples_(std::max<size_t>(capacity, 1)) {}
+
+  /// @return true if the phase times are measured (i.e., RAISIM_SOLVER_PROFILING is defined)
+  static constexpr bool isTimingEnabled() {
+#ifdef RAISIM_SOLVER_PROFILING
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * start a new sample. Called by integrate(World&, SolverProfiler&)
+   * @param[in] worldTime the world time of the step */
+  void beginStep(double worldTime) {
+    head_ = (head_ + 1) % samples_.size();
+    size_ = std::min(size_ + 1, samples_.size());
+    samples_[head_] = Sample();
+    samples_[head_].worldTime = worldTime;
+  }
+
+  /**
+   * complete the current sample. Called by integrate(World&, SolverProfiler&)
+   * @param[in] contacts the number of contact problems
+   * @param[in] iterations the loop counter of the contact solver
+   * @param[in] errorHistory the error history of the contact solver */
+  void endStep(size_t contacts, int iterations, const std::vector<double> &errorHistory) {
+    auto &sample = current();
+    sample.contacts = contacts;
+    sample.iterations = iterations;
+    sample.error = errorHistory.empty() ? 0. : errorHistory.back();
+    if (sink_) sink_(sample.worldTime, toDataPoint(sample));
+  }
+
+  /// @return the number of samples kept
+  [[nodiscard]] size_t size() const { return size_; }
+
+  /**
+   * @param[in] i index of the sample. 0 is the oldest
+   * @return the sample */
+  [[nodiscard]] const Sample &getSample(size_t i) const {
+    return samples_[(head_ + samples_.size() - size_ + 1 + i) % samples_.size()];
+  }
+
+  /// @return the last sample
+  [[nodiscard]] const Sample &getLatest() const { return samples_[head_]; }
+
+  /// @return the average of the samples kept
+  [[nodiscard]] Sample getAverage() const {
+    Sample average;
+    if (size_ == 0) return average;
+    double iterations = 0.;
+    for (size_t i = 0; i < size_; i++) {
+      auto &sample = getSample(i);
+      for (int p = 0; p < PHASE_NUM; p++) average.phaseTime[p] += sample.phaseTime[p] / size_;
+      average.contacts += sample.contacts;
+      iterations += sample.iterations;
+      average.error += sample.error / size_;
+    }
+    average.worldTime = getLatest().worldTime;
+    average.contacts /= size_;
+    average.iterations = int(iterations / size_ + 0.5);
+    return average;
+  }
+
+  void clear() { size_ = 0; }
+
+  /// @return the names of the entries of toDataPoint
+  static std::vector<std::string> getColumnNames() {
+    return {"collision detection [ms]", "solver and integration [ms]", "contacts", "iterations", "error"};
+  }
+
+  /**
+   * @param[in] sample a sample
+   * @return the sample as a data point of a TimeSeriesGraph with the columns of getColumnNames */
+  static VecDyn toDataPoint(const Sample &sample) {
+    VecDyn point(5);
+    point[0] = sample.phaseTime[COLLISION_DETECTION] * 1e3;
+    point[1] = sample.phaseTime[SOLVER_AND_INTEGRATION] * 1e3;
+    point[2] = double(sample.contacts);
+    point[3] = double(sample.iterations);
+    point[4] = sample.error;
+    return point;
+  }
+
+  /**
+   * @param[in] sink called with the world time and the data point of every completed sample (see
+   * RaisimServer::addSolverProfilerGraph). An empty function removes it */
+  void setSink(std::function<void(double, const VecDyn &)> sink) { sink_ = std::move(sink); }
+
+ private:
+  Sample &current() { return samples_[head_]; }
+
+  std::vector<Sample> samples_;
+  size_t head_ = 0, size_ = 0;
+  std::function<void(double, const VecDyn &)> sink_;
+};
+
+/**
+ * integrate the world and record the phase times, the number of contact problems and the convergence of the contact
+ * solver. The phase times are measured only if RAISIM_SOLVER_PROFILING is defined.
+ * It is equivalent to "world.integrate1(); world.integrate2();"
+ * @param[in] world the world
+ * @param[in,out] profiler the samples of the previous steps */
+inline void integrate(World &world, SolverProfiler &profiler) {
+  profiler.beginStep(world.getWorldTime());
+  {
+    SolverProfiler::Scope scope(profiler, SolverProfiler::COLLISION_DETECTION);
+    world.integrate1();
+  }
+  const size_t contacts = world.getContactProblem()->size();
+  {
+    SolverProfiler::Scope scope(profiler, SolverProfiler::SOLVER_AND_INTEGRATION);
+    world.integrate2();
+  }
+  const auto &solver = world.getContactSolver();
+  profiler.endStep(contacts, solver.getLoopCounter(), solver.getErrorHistory());
+}
+
+}
+
+#endif // RAISIM_INCLUDE_RAISIM_SOLVERPROFILER_HPP_
@@ -13,8 +13,14 @@
 # include <algorithm>
 # include <random>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define RAISIM_TERRAIN_AVX2 1
+#endif
+
 namespace raisim {
 
+
 class noiseUtils {
 
  public:
@@ -93,6 +99,84 @@ class PerlinNoise {
                           Grad(p[BB + 1], x - 1, y - 1, z - 1))));
   }
 
+  /// sample(x, y, 0) without the interpolation along z, which has no effect at z = 0
+  double sample(double x, double y) const {
+    const size_t X = static_cast<size_t>(noiseUtils::fastFloor(x)) & 255;
+    const size_t Y = static_cast<size_t>(noiseUtils::fastFloor(y)) & 255;
+
+    x -= noiseUtils::fastFloor(x);
+    y -= noiseUtils::fastFloor(y);
+
+    const double u = Fade(x);
+    const double v = Fade(y);
+
+    const size_t A = p[X] + Y, AA = p[A], AB = p[A + 1];
+    const size_t B = p[X + 1] + Y, BA = p[B], BB = p[B + 1];
+
+    return Lerp(v, Lerp(u, Grad(p[AA], x, y, 0.), Grad(p[BA], x - 1, y, 0.)),
+                Lerp(u, Grad(p[AB], x, y - 1, 0.), Grad(p[BB], x - 1, y - 1, 0.)));
+  }
+
+#ifdef RAISIM_TERRAIN_AVX2
+  /// sample(x, y) of four points. It equals the scalar sample for non-negative coordinates, if FMA is not used
+  __attribute__((target("avx2"))) __m256d sample4(__m256d x, __m256d y) const {
+    const __m256d fx = floor4(x), fy = floor4(y);
+    const __m256i mask = _mm256_set1_epi64x(255), one = _mm256_set1_epi64x(1);
+    const __m256i X = _mm256_and_si256(_mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(fx)), mask);
+    const __m256i Y = _mm256_and_si256(_mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(fy)), mask);
+    x = _mm256_sub_pd(x, fx);
+    y = _mm256_sub_pd(y, fy);
+
+    const __m256d u = fade4(x), v = fade4(y);
+    const __m256i A = _mm256_add_epi64(gather4(X), Y), AA = gather4(A), AB = gather4(_mm256_add_epi64(A, one));
+    const __m256i B = _mm256_add_epi64(gather4(_mm256_add_epi64(X, one)), Y), BA = gather4(B),
+        BB = gather4(_mm256_add_epi64(B, one));
+
+    const __m256d x1 = _mm256_sub_pd(x, _mm256_set1_pd(1.)), y1 = _mm256_sub_pd(y, _mm256_set1_pd(1.));
+    return lerp4(v, lerp4(u, grad4(gather4(AA), x, y), grad4(gather4(BA), x1, y)),
+                 lerp4(u, grad4(gather4(AB), x, y1), grad4(gather4(BB), x1, y1)));
+  }
+#endif
+
+ private:
+#ifdef RAISIM_TERRAIN_AVX2
+  // noiseUtils::fastFloor, which differs from floor at negative integers
+  __attribute__((target("avx2"))) static __m256d floor4(__m256d f) {
+    const __m256d truncated = _mm256_round_pd(f, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m256d negative = _mm256_cmp_pd(f, _mm256_setzero_pd(), _CMP_LT_OQ);
+    return _mm256_sub_pd(truncated, _mm256_and_pd(negative, _mm256_set1_pd(1.)));
+  }
+
+  __attribute__((target("avx2"))) static __m256d fade4(__m256d t) {
+    const __m256d inner = _mm256_add_pd(
+        _mm256_mul_pd(t, _mm256_sub_pd(_mm256_mul_pd(t, _mm256_set1_pd(6.)), _mm256_set1_pd(15.))), _mm256_set1_pd(10.));
+    return _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(t, t), t), inner);
+  }
+
+  __attribute__((target("avx2"))) static __m256d lerp4(__m256d t, __m256d a, __m256d b) {
+    return _mm256_add_pd(a, _mm256_mul_pd(t, _mm256_sub_pd(b, a)));
+  }
+
+  __attribute__((target("avx2"))) __m256i gather4(__m256i index) const {
+    return _mm256_mask_i64gather_epi64(_mm256_setzero_si256(), reinterpret_cast<const long long *>(p), index,
+                                       _mm256_set1_epi64x(-1), 8);
+  }
+
+  // Grad(hash, x, y, 0)
+  __attribute__((target("avx2"))) static __m256d grad4(__m256i hash, __m256d x, __m256d y) {
+    const __m256i h = _mm256_and_si256(hash, _mm256_set1_epi64x(15));
+    const __m256d below8 = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(8), h));
+    const __m256d below4 = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(4), h));
+    const __m256d useX = _mm256_castsi256_pd(_mm256_or_si256(_mm256_cmpeq_epi64(h, _mm256_set1_epi64x(12)),
+                                                             _mm256_cmpeq_epi64(h, _mm256_set1_epi64x(14))));
+    const __m256d u = _mm256_blendv_pd(y, x, below8);
+    const __m256d v = _mm256_blendv_pd(_mm256_and_pd(useX, x), y, below4);
+    // bit 0 and bit 1 of the hash flip the sign bits of u and v
+    const __m256d signU = _mm256_castsi256_pd(_mm256_slli_epi64(h, 63));
+    const __m256d signV = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_srli_epi64(h, 1), 63));
+    return _mm256_add_pd(_mm256_xor_pd(u, signU), _mm256_xor_pd(v, signV));
+  }
+#endif
 };
 
 struct TerrainProperties {
@@ -197,7 +281,77 @@ class TerrainGenerator {
     return height_;
   }
 
+  /**
+   * generate row y of the heights of generatePerlinFractalTerrain() with four samples at once (AVX2). The noise is
+   * evaluated in the plane z = 0. Different rows can be generated concurrently (see raisim/TerrainGeneratorParallel.hpp)
+   * @param[in] y the row. The height map must have xSamples * ySamples entries */
+  void generatePerlinFractalRow(size_t y) {
+    const double xScale = terrainProperties_.frequency * terrainProperties_.xSize / terrainProperties_.xSamples;
+    const double yScale = terrainProperties_.frequency * terrainProperties_.ySize / terrainProperties_.ySamples;
+    generatePerlinFractalRow(xScale, yScale * int(y), &height_[y * terrainProperties_.xSamples]);
+  }
+
  private:
+  // a row of generatePerlinFractalTerrain(). The height offset and the steps are applied in the same pass
+  void generatePerlinFractalRow(double xScale, double y, double *row) const {
+    const size_t n = terrainProperties_.xSamples;
+    size_t x = 0;
+#ifdef RAISIM_TERRAIN_AVX2
+    if (__builtin_cpu_supports("avx2")) x = perlinFractalNoiseAvx2(xScale, y, n, row);
+#endif
+    for (; x < n; x++) row[x] = planarPerlinFractalNoise_01(xScale * int(x), y);
+
+    const double stepSize = terrainProperties_.stepSize;
+    for (x = 0; x < n; x++) {
+      double e = row[x] * terrainProperties_.zScale;
+      if (stepSize > 0) e = (double) noiseUtils::fastFloor(e / stepSize) * stepSize;
+      row[x] = e + terrainProperties_.heightOffset;
+    }
+  }
+
+  // singlePerlinFractalNoise_01(x, y, 0.0)
+  double planarPerlinFractalNoise_01(double x, double y) const {
+    double sum = perlinNoise_.sample(x, y);
+    double amp = 1;
+    size_t i = 0;
+
+    while (++i < terrainProperties_.fractalOctaves) {
+      x *= terrainProperties_.fractalLacunarity;
+      y *= terrainProperties_.fractalLacunarity;
+
+      amp *= terrainProperties_.fractalGain;
+      sum += perlinNoise_.sample(x, y) * amp;
+    }
+    return sum * fractalBound_ * 0.5 + 0.5;
+  }
+
+#ifdef RAISIM_TERRAIN_AVX2
+  // planarPerlinFractalNoise_01 of the samples x = 0, 1, ... of a row in groups of four
+  __attribute__((target("avx2"))) size_t perlinFractalNoiseAvx2(double xScale, double y, size_t n, double *row) const {
+    const __m256d lacunarity = _mm256_set1_pd(terrainProperties_.fractalLacunarity);
+    const __m256d scale = _mm256_set1_pd(xScale), lanes = _mm256_set_pd(3., 2., 1., 0.);
+    size_t x = 0;
+    for (; x + 4 <= n; x += 4) {
+      __m256d px = _mm256_mul_pd(scale, _mm256_add_pd(_mm256_set1_pd(double(x)), lanes));
+      __m256d py = _mm256_set1_pd(y);
+      __m256d sum = perlinNoise_.sample4(px, py);
+      double amp = 1;
+      size_t i = 0;
+
+      while (++i < terrainProperties_.fractalOctaves) {
+        px = _mm256_mul_pd(px, lacunarity);
+        py = _mm256_mul_pd(py, lacunarity);
+
+        amp *= terrainProperties_.fractalGain;
+        sum = _mm256_add_pd(sum, _mm256_mul_pd(perlinNoise_.sample4(px, py), _mm256_set1_pd(amp)));
+      }
+      sum = _mm256_mul_pd(_mm256_mul_pd(sum, _mm256_set1_pd(fractalBound_)), _mm256_set1_pd(0.5));
+      _mm256_storeu_pd(row + x, _mm256_add_pd(sum, _mm256_set1_pd(0.5)));
+    }
+    return x;
+  }
+#endif
+
   //within [-1.0, 1.0]
   double singlePerlinFractalNoise(double x, double y, double z) const {
     double sum = perlinNoise_.sample(x, y, z);
@@ -0,0 +1,35 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_TERRAINGENERATORPARALLEL_HPP_
+#define RAISIM_INCLUDE_RAISIM_TERRAINGENERATORPARALLEL_HPP_
+
+#include <vector>
+#include "raisim/Terrain.hpp"
+#include "raisim/ThreadPool.hpp"
+
+namespace raisim {
+
+/**
+ * TerrainGenerator::generatePerlinFractalTerrain() with four samples at once (AVX2) and the rows distributed over the
+ * threads of a pool. The heights equal the ones of generatePerlinFractalTerrain() unless the compiler fuses
+ * multiplications and additions (e.g., -mfma), which changes the rounding of the scalar code.
+ * @param[in,out] generator the terrain generator
+ * @param[in] pool the threads. nullptr generates the rows on the calling thread
+ * @return the heights (generator.getHeightMap()) */
+inline std::vector<double> &generatePerlinFractalTerrain(TerrainGenerator &generator, ThreadPool *pool = nullptr) {
+  auto &prop = generator.getTerrainProp();
+  auto &height = generator.getHeightMap();
+  height.resize(prop.xSamples * prop.ySamples);
+  if (pool)
+    pool->parallelFor(prop.ySamples, [&generator](size_t y) { generator.generatePerlinFractalRow(y); });
+  else
+    for (size_t y = 0; y < prop.ySamples; y++) generator.generatePerlinFractalRow(y);
+  return height;
+}
+
+}
+
+#endif // RAISIM_INCLUDE_RAISIM_TERRAINGENERATORPARALLEL_HPP_
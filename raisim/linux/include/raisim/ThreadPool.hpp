@@ -0,0 +1,143 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_THREADPOOL_HPP_
+#define RAISIM_INCLUDE_RAISIM_THREADPOOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace raisim {
+
+/**
+ * A persistent thread pool for data-parallel loops.
+ * parallelFor splits the index range into one contiguous block per thread. A thread that finished its block steals
+ * the remaining indices of the other blocks one by one, so that uneven work (e.g., worlds with many contacts) is
+ * balanced. The calling thread works as the first thread. The workers sleep between the loops. */
+class ThreadPool {
+ public:
+  /**
+   * @param[in] threads the number of threads including the calling thread. 0 uses all hardware threads */
+  explicit ThreadPool(int threads = 0) {
+    if (threads <= 0) threads = int(std::max(std::thread::hardware_concurrency(), 1u));
+    blocks_ = std::unique_ptr<Block[]>(new Block[threads]);
+    nThreads_ = threads;
+    for (int i = 1; i < threads; i++)
+      workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      terminate_ = true;
+    }
+    start_.notify_all();
+    for (auto &worker: workers_) worker.join();
+  }
+
+  /// @return the number of threads including the calling thread
+  [[nodiscard]] int getNumberOfThreads() const { return nThreads_; }
+
+  /**
+   * call task(i) for every i in [0, n). It returns when all calls returned. It must not be called recursively.
+   * @param[in] n the number of indices
+   * @param[in] task the function called with each index */
+  void parallelFor(size_t n, const std::function<void(size_t)> &task) {
+    if (n == 0) return;
+    if (nThreads_ == 1 || n == 1) {
+      for (size_t i = 0; i < n; i++) task(i);
+      return;
+    }
+
+    for (int t = 0; t < nThreads_; t++) {
+      blocks_[t].next.store(n * t / nThreads_, std::memory_order_relaxed);
+      blocks_[t].end = n * (t + 1) / nThreads_;
+    }
+    remaining_.store(n, std::memory_order_relaxed);
+
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      task_ = &task;
+      generation_++;
+    }
+    start_.notify_all();
+
+    work(0, task);
+
+    // the last indices are being processed by the workers. A worker that woke up late may still be in work()
+    while (true) {
+      if (remaining_.load(std::memory_order_acquire) == 0) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (active_ == 0) {
+          task_ = nullptr;
+          return;
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+
+ private:
+  struct alignas(64) Block {
+    std::atomic<size_t> next{0};
+    size_t end = 0;
+  };
+
+  void workerLoop(int thread) {
+    uint64_t generation = 0;
+    while (true) {
+      const std::function<void(size_t)> *task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_.wait(lock, [&] { return terminate_ || (generation_ != generation && task_); });
+        if (terminate_) return;
+        generation = generation_;
+        task = task_;
+        active_++;
+      }
+      work(thread, *task);
+      std::lock_guard<std::mutex> guard(mutex_);
+      active_--;
+    }
+  }
+
+  // process the own block first and then steal from the others
+  void work(int thread, const std::function<void(size_t)> &task) {
+    size_t done = 0;
+    for (int k = 0; k < nThreads_; k++) {
+      auto &block = blocks_[(thread + k) % nThreads_];
+      for (size_t i = block.next.fetch_add(1, std::memory_order_relaxed); i < block.end;
+           i = block.next.fetch_add(1, std::memory_order_relaxed)) {
+        task(i);
+        done++;
+      }
+    }
+    if (done) remaining_.fetch_sub(done, std::memory_order_acq_rel);
+  }
+
+  int nThreads_;
+  std::unique_ptr<Block[]> blocks_;
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  const std::function<void(size_t)> *task_ = nullptr;
+  uint64_t generation_ = 0;
+  int active_ = 0;
+  bool terminate_ = false;
+  std::atomic<size_t> remaining_{0};
+};
+
+}
+
+#endif // RAISIM_INCLUDE_RAISIM_THREADPOOL_HPP_
@@ -8,6 +8,8 @@
 
 #include <memory>
 #include <algorithm>
+#include <cstring>
+#include <type_traits>
 
 #include "raisim/helper.hpp"
 #include "raisim/object/Object.hpp"
@@ -48,12 +50,25 @@
 
 namespace raisim {
 
+class RayCaster;
+class ThreadPool;
+struct RayBatch;
+struct RayHits;
+
 /**
  * @param[in] group Collision group ID
  * @return Collision group. Can also be used as a collision mask.
  */
 static CollisionGroup COLLISION(CollisionGroup group) { return CollisionGroup(1) << group; }
 
+/**
+ * A checkpoint of a world (see World::saveState). The buffer grows at the first save and is reused afterwards.
+ * It contains pointers into the world (e.g., the objects of the contacts), so it is only valid for the world that saved
+ * it. */
+struct WorldState {
+  std::vector<char> buffer;
+};
+
 class World {
 
   struct XmlObjectClass {
@@ -488,6 +503,18 @@ class World {
                                   size_t localId = size_t(-10),
                                   CollisionGroup collisionMask = CollisionGroup(-1));
 
+  /**
+   * Casts many rays at once. Unlike rayTest, it is reentrant: the acceleration structure and the results belong to
+   * the caller. The caster is updated with the current collision bodies and the rays are cast in packets, in parallel
+   * if a thread pool is given. To cast several batches against the same state (or from several threads), call
+   * caster.update(getObjList()) once and caster.cast(...) for each batch.
+   * @param[in] caster the acceleration structure. It keeps the mesh hierarchies between the calls
+   * @param[in] rays the origins, directions and lengths of the rays
+   * @param[out] hits the closest hit of each ray
+   * Defined in raisim/RayCaster.hpp, which has to be included.
+   * @param[in] pool threads casting the rays. nullptr casts on the calling thread */
+  inline void rayTestBatch(RayCaster &caster, const RayBatch &rays, RayHits &hits, ThreadPool *pool = nullptr);
+
   /**
    * removes an object
    * @param[in] obj object to be removed */
@@ -654,6 +681,141 @@ class World {
   [[nodiscard]] const MaterialPairProperties& getMaterialPairProperties (const std::string& mat1, const std::string& mat2) const {
     return mat_.getMaterialPairProp(mat1, mat2); }
 
+  /**
+   * save the state of the world into a flat buffer: the world time, the generalized coordinates and velocities of the
+   * articulated systems, the poses and velocities of the non-static single bodies, the activation of the wires, and the
+   * contacts and contact problems of the last step.
+   * The inputs (e.g., PD targets and external forces) are not saved. The iteration order of the contact solver
+   * alternates in every step unless it is fixed with setContactSolverIterationOrder. Fix it for identical branches.
+   * @param[out] state the checkpoint. It can be restored into this world (not into a copy of it) as long as no object is
+   * added or removed */
+  inline void saveState(WorldState &state) {
+    static_assert(std::is_trivially_copyable<Contact>::value &&
+                  std::is_trivially_copyable<contact::Single3DContactProblem>::value, "Contacts must be copyable");
+    size_t size = 6 * sizeof(double) + contactProblems_.size() * sizeof(contact::Single3DContactProblem) + wire_.size();
+    for (auto ob: objectList_) {
+      size += sizeof(double) + ob->contacts_.size() * sizeof(Contact);
+      if (ob->getObjectType() == ObjectType::ARTICULATED_SYSTEM) {
+        auto as = static_cast<ArticulatedSystem *>(ob);
+        size += (as->gc_.size() + as->gv_.size()) * sizeof(double);
+      } else if (ob->getBodyType() != BodyType::STATIC) {
+        size += 13 * sizeof(double);
+      }
+    }
+
+    state.buffer.resize(size);
+    char *data = state.buffer.data();
+    auto put = [&data](const void *src, size_t bytes) {
+      memcpy(data, src, bytes);
+      data += bytes;
+    };
+    auto putSize = [&put](size_t value) { put(&value, sizeof(value)); };
+
+    putSize(reinterpret_cast<size_t>(this));
+    putSize(objectConfiguration_);
+    putSize(stepsTaken_);
+    put(&worldTime_, sizeof(double));
+    putSize(contactProblems_.size());
+    putSize(reinterpret_cast<size_t>(contactProblems_.data()));
+    put(contactProblems_.data(), contactProblems_.size() * sizeof(contact::Single3DContactProblem));
+
+    for (auto ob: objectList_) {
+      if (ob->getObjectType() == ObjectType::ARTICULATED_SYSTEM) {
+        auto as = static_cast<ArticulatedSystem *>(ob);
+        put(as->gc_.data(), as->gc_.size() * sizeof(double));
+        put(as->gv_.data(), as->gv_.size() * sizeof(double));
+      } else if (ob->getBodyType() != BodyType::STATIC) {
+        auto sob = static_cast<SingleBodyObject *>(ob);
+        Vec<3> position, linVel, angVel;
+        Vec<4> quaternion;
+        sob->getPosition(position);
+        sob->getQuaternion(quaternion);
+        sob->getLinearVelocity(linVel);
+        sob->getAngularVelocity(angVel);
+        put(position.ptr(), 3 * sizeof(double));
+        put(quaternion.ptr(), 4 * sizeof(double));
+        put(linVel.ptr(), 3 * sizeof(double));
+        put(angVel.ptr(), 3 * sizeof(double));
+      }
+      putSize(ob->contacts_.size());
+      put(ob->contacts_.data(), ob->contacts_.size() * sizeof(Contact));
+    }
+
+    for (auto &wire: wire_) *data++ = char(wire->isActive);
+  }
+
+  /**
+   * restore a state saved by saveState of this world. The kinematics of the articulated systems are updated.
+   * @param[in] state the checkpoint */
+  inline void restoreState(const WorldState &state) {
+    const char *data = state.buffer.data(), *end = data + state.buffer.size();
+    RSFATAL_IF(state.buffer.empty(), "The state is empty")
+    auto get = [&data, end](void *dst, size_t bytes) {
+      RSFATAL_IF(bytes > size_t(end - data), "The state is truncated or does not match the objects in the world")
+      memcpy(dst, data, bytes);
+      data += bytes;
+    };
+    auto getSize = [&get]() {
+      size_t value;
+      get(&value, sizeof(value));
+      return value;
+    };
+    // the number of elements that follow, checked before the containers are resized
+    auto getCount = [&getSize, &data, end](size_t elementSize) {
+      const size_t count = getSize();
+      RSFATAL_IF(count > size_t(end - data) / elementSize, "The state is truncated or does not match the objects in the world")
+      return count;
+    };
+
+    // the contacts point to objects and impulses of the world that saved the state
+    RSFATAL_IF(getSize() != reinterpret_cast<size_t>(this), "The state was saved by another world")
+    RSFATAL_IF(getSize() != objectConfiguration_, "The state was saved with different objects in the world")
+    stepsTaken_ = getSize();
+    get(&worldTime_, sizeof(double));
+    const size_t problems = getCount(sizeof(contact::Single3DContactProblem));
+    auto savedProblems = getSize();
+    contactProblems_.resize(problems);
+    get(contactProblems_.data(), contactProblems_.size() * sizeof(contact::Single3DContactProblem));
+
+    // the contacts point to the impulses in the contact problems, which may have moved
+    const size_t problemBytes = contactProblems_.size() * sizeof(contact::Single3DContactProblem);
+    auto rebase = [&](Contact &contact) {
+      auto offset = reinterpret_cast<size_t>(contact.impulse_) - savedProblems;
+      if (contact.impulse_ && offset < problemBytes)
+        contact.impulse_ = reinterpret_cast<Vec<3> *>(reinterpret_cast<char *>(contactProblems_.data()) + offset);
+    };
+
+    for (auto ob: objectList_) {
+      if (ob->getObjectType() == ObjectType::ARTICULATED_SYSTEM) {
+        auto as = static_cast<ArticulatedSystem *>(ob);
+        get(as->gc_.data(), as->gc_.size() * sizeof(double));
+        get(as->gv_.data(), as->gv_.size() * sizeof(double));
+        as->updateKinematics();
+      } else if (ob->getBodyType() != BodyType::STATIC) {
+        auto sob = static_cast<SingleBodyObject *>(ob);
+        Vec<3> position, linVel, angVel;
+        Vec<4> quaternion;
+        get(position.ptr(), 3 * sizeof(double));
+        get(quaternion.ptr(), 4 * sizeof(double));
+        get(linVel.ptr(), 3 * sizeof(double));
+        get(angVel.ptr(), 3 * sizeof(double));
+        sob->setPosition(position);
+        sob->setOrientation(quaternion);
+        sob->setVelocity(linVel, angVel);
+      }
+      ob->contacts_.resize(getCount(sizeof(Contact)));
+      get(ob->contacts_.data(), ob->contacts_.size() * sizeof(Contact));
+      for (auto &contact: ob->contacts_) rebase(contact);
+    }
+
+    for (auto &wire: wire_) {
+      char active;
+      get(&active, 1);
+      wire->isActive = active != 0;
+    }
+    RSFATAL_IF(data != end, "The state does not match the objects in the world")
+  }
+
   /**
    * locks world mutex. This can be used if you use raisim in a multi-threaded environment.
    */
@@ -0,0 +1,142 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_WORLDPOOL_HPP_
+#define RAISIM_INCLUDE_RAISIM_WORLDPOOL_HPP_
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "raisim/World.hpp"
+#include "raisim/ThreadPool.hpp"
+
+namespace raisim {
+
+/**
+ * Owns N independent worlds, each with one robot of the same model (e.g., vectorized RL environments), and steps
+ * them in parallel on a persistent thread pool.
+ * The states, the PD targets and the contact summaries of all robots are kept in contiguous row-major buffers.
+ * Row i belongs to world i. The PD targets are written by the user and applied to all robots in step(). The states
+ * and the contact forces are gathered after step(). Each row is copied with a single memcpy in the worker thread of
+ * its world, so observations and actions are exchanged without per-world calls. */
+class WorldPool {
+ public:
+  using RowMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+  /**
+   * @param[in] nWorlds the number of worlds
+   * @param[in] setUp builds the scene of a world and returns its robot. It is called with the world and its index
+   * @param[in] nThreads the number of threads stepping the worlds. 0 uses all hardware threads */
+  WorldPool(int nWorlds, const std::function<ArticulatedSystem *(World &, int)> &setUp, int nThreads = 0)
+      : pool_(nThreads) {
+    RSFATAL_IF(nWorlds < 1, "A world pool needs at least one world")
+
+    for (int i = 0; i < nWorlds; i++) {
+      worlds_.emplace_back(new World);
+      robots_.push_back(setUp(*worlds_.back(), i));
+      RSFATAL_IF(!robots_.back(), "The set-up function did not return a robot")
+    }
+
+    gcDim_ = robots_[0]->getGeneralizedCoordinateDim();
+    dof_ = robots_[0]->getDOF();
+    nBodies_ = robots_[0]->getBodyNames().size();
+    for (auto robot: robots_)
+      RSFATAL_IF(robot->getGeneralizedCoordinateDim() != gcDim_ || robot->getDOF() != dof_,
+                 "All robots of a world pool must have the same model")
+
+    gc_.setZero(nWorlds, gcDim_);
+    gv_.setZero(nWorlds, dof_);
+    pdPosition_.setZero(nWorlds, gcDim_);
+    pdVelocity_.setZero(nWorlds, dof_);
+    contactForce_.setZero(nWorlds, nBodies_);
+    pdPositionBuffer_.resize(nWorlds);
+    pdVelocityBuffer_.resize(nWorlds);
+
+    Eigen::VectorXd position(gcDim_), velocity(dof_);
+    for (int i = 0; i < nWorlds; i++) {
+      robots_[i]->getPdTarget(position, velocity);
+      pdPosition_.row(i) = position.transpose();
+      pdVelocity_.row(i) = velocity.transpose();
+      pdPositionBuffer_[i].resize(gcDim_);
+      pdVelocityBuffer_[i].resize(dof_);
+      gather(i);
+    }
+  }
+
+  WorldPool(const WorldPool &) = delete;
+  WorldPool &operator=(const WorldPool &) = delete;
+
+  /**
+   * apply the PD targets, integrate every world and gather the states and the contact forces
+   * @param[in] substeps the number of integrations per world */
+  void step(int substeps = 1) {
+    pool_.parallelFor(worlds_.size(), [this, substeps](size_t i) {
+      memcpy(pdPositionBuffer_[i].data(), pdPosition_.row(i).data(), gcDim_ * sizeof(double));
+      memcpy(pdVelocityBuffer_[i].data(), pdVelocity_.row(i).data(), dof_ * sizeof(double));
+      robots_[i]->setPdTarget(pdPositionBuffer_[i], pdVelocityBuffer_[i]);
+      for (int s = 0; s < substeps; s++) worlds_[i]->integrate();
+      gather(i);
+    });
+  }
+
+  /**
+   * set the states of all robots (e.g., reset)
+   * @param[in] gc the generalized coordinates (N x gcDim)
+   * @param[in] gv the generalized velocities (N x dof) */
+  void setStates(const RowMatrix &gc, const RowMatrix &gv) {
+    RSFATAL_IF(gc.rows() != gc_.rows() || gc.cols() != gc_.cols() || gv.rows() != gv_.rows() || gv.cols() != gv_.cols(),
+               "State dimension mismatch")
+    pool_.parallelFor(worlds_.size(), [&](size_t i) {
+      robots_[i]->setState(gc.row(i).transpose(), gv.row(i).transpose());
+      gather(i);
+    });
+  }
+
+  /// generalized coordinates of all robots (N x gcDim). Updated in step()
+  [[nodiscard]] const RowMatrix &getGeneralizedCoordinates() const { return gc_; }
+
+  /// generalized velocities of all robots (N x dof). Updated in step()
+  [[nodiscard]] const RowMatrix &getGeneralizedVelocities() const { return gv_; }
+
+  /// the norm of the contact impulses of each body divided by the time step (N x number of bodies). Updated in step()
+  [[nodiscard]] const RowMatrix &getContactForces() const { return contactForce_; }
+
+  /// position targets of all robots (N x gcDim). Applied in the next step()
+  [[nodiscard]] RowMatrix &getPdPositionTargets() { return pdPosition_; }
+
+  /// velocity targets of all robots (N x dof). Applied in the next step()
+  [[nodiscard]] RowMatrix &getPdVelocityTargets() { return pdVelocity_; }
+
+  [[nodiscard]] int getNumberOfWorlds() const { return int(worlds_.size()); }
+  [[nodiscard]] World &getWorld(int i) { return *worlds_[i]; }
+  [[nodiscard]] ArticulatedSystem *getRobot(int i) { return robots_[i]; }
+  [[nodiscard]] ThreadPool &getThreadPool() { return pool_; }
+
+ private:
+  void gather(size_t i) {
+    auto robot = robots_[i];
+    memcpy(gc_.row(i).data(), robot->getGeneralizedCoordinate().data(), gcDim_ * sizeof(double));
+    memcpy(gv_.row(i).data(), robot->getGeneralizedVelocity().data(), dof_ * sizeof(double));
+
+    double *force = contactForce_.row(i).data();
+    std::fill(force, force + nBodies_, 0.);
+    const double inverseTimeStep = 1. / worlds_[i]->getTimeStep();
+    for (auto &contact: robot->getContacts())
+      if (!contact.skip() && contact.getlocalBodyIndex() < nBodies_)
+        force[contact.getlocalBodyIndex()] += contact.getImpulse().norm() * inverseTimeStep;
+  }
+
+  ThreadPool pool_;
+  std::vector<std::unique_ptr<World>> worlds_;
+  std::vector<ArticulatedSystem *> robots_;
+  size_t gcDim_, dof_, nBodies_;
+  RowMatrix gc_, gv_, pdPosition_, pdVelocity_, contactForce_;
+  std::vector<VecDyn> pdPositionBuffer_, pdVelocityBuffer_;
+};
+
+}
+
+#endif // RAISIM_INCLUDE_RAISIM_WORLDPOOL_HPP_
@@ -7,11 +7,101 @@
 #ifndef RAISIM_HEIGHTMAP_HPP
 #define RAISIM_HEIGHTMAP_HPP
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <raisim/object/singleBodies/SingleBodyObject.hpp>
 #include <raisim/Terrain.hpp>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define RAISIM_HEIGHTMAP_AVX2 1
+#endif
+
 namespace raisim {
 
+class HeightMap;
+
+/**
+ * The rectangles of samples of a heightmap changed by HeightMap::updateRegion, e.g., to send only these samples to the
+ * visualizer (see RaisimServer::getHeightMapRegions). It also keeps the collision bounds of the heightmap, so that
+ * updateRegion does not have to visit the other samples. Rectangles that overlap or touch are merged if their bounding
+ * box is not larger than the two rectangles together.
+ */
+class HeightMapRegions {
+  friend class HeightMap;
+
+ public:
+  /// the rectangles are merged into their bounding box beyond this number
+  static constexpr size_t MAX_RECTANGLES = 64;
+
+  /// the columns [x0, x0 + width) and the rows [y0, y0 + height) of HeightMap::getHeightVector()
+  struct Rectangle {
+    size_t x0, y0, width, height;
+    [[nodiscard]] size_t area() const { return width * height; }
+  };
+
+  /**
+   * @param[in] rectangle the changed samples */
+  void add(const Rectangle &rectangle) {
+    Rectangle added = rectangle;
+    for (size_t i = 0; i < rectangles_.size();) {
+      const auto &other = rectangles_[i];
+      const size_t x0 = std::min(added.x0, other.x0), x1 = std::max(added.x0 + added.width, other.x0 + other.width);
+      const size_t y0 = std::min(added.y0, other.y0), y1 = std::max(added.y0 + added.height, other.y0 + other.height);
+      const bool touching = added.x0 <= other.x0 + other.width && other.x0 <= added.x0 + added.width &&
+          added.y0 <= other.y0 + other.height && other.y0 <= added.y0 + added.height;
+      if (!touching || (x1 - x0) * (y1 - y0) > added.area() + other.area()) {
+        i++;
+        continue;
+      }
+      // the merged rectangle may now touch the rectangles before i
+      added = {x0, y0, x1 - x0, y1 - y0};
+      rectangles_[i] = rectangles_.back();
+      rectangles_.pop_back();
+      i = 0;
+    }
+    rectangles_.push_back(added);
+
+    if (rectangles_.size() > MAX_RECTANGLES) {
+      Rectangle box = rectangles_.front();
+      for (const auto &r: rectangles_) {
+        const size_t x1 = std::max(box.x0 + box.width, r.x0 + r.width), y1 = std::max(box.y0 + box.height, r.y0 + r.height);
+        box.x0 = std::min(box.x0, r.x0);
+        box.y0 = std::min(box.y0, r.y0);
+        box.width = x1 - box.x0;
+        box.height = y1 - box.y0;
+      }
+      rectangles_.assign(1, box);
+    }
+  }
+
+  /// @return the changed rectangles
+  [[nodiscard]] const std::vector<Rectangle> &getRectangles() const { return rectangles_; }
+
+  /// @return the number of samples in the rectangles
+  [[nodiscard]] size_t getNumberOfSamples() const {
+    size_t samples = 0;
+    for (const auto &r: rectangles_) samples += r.area();
+    return samples;
+  }
+
+  /// @return true if no sample changed
+  [[nodiscard]] bool empty() const { return rectangles_.empty(); }
+
+  /// forget the rectangles (e.g., after they were sent)
+  void clear() { rectangles_.clear(); }
+
+  /// the collision bounds are recomputed in the next HeightMap::updateRegion. Call it after HeightMap::update
+  void resetBounds() { boundsValid_ = false; }
+
+ private:
+  std::vector<Rectangle> rectangles_;
+  const HeightMap *heightMap_ = nullptr;
+  bool boundsValid_ = false;
+  double minHeight_ = 0., maxHeight_ = 0.;
+};
+
 class HeightMap final : public SingleBodyObject {
 
  public:
@@ -86,6 +176,77 @@ class HeightMap final : public SingleBodyObject {
    */
   void update(double centerX, double centerY, double sizeX, double sizeY, const std::vector<double> &height);
 
+  /**
+   * Update a rectangle of samples, e.g., the footprints on deformable terrain. Only these samples are written into the
+   * heights and into the collision data, whereas update() replaces all of them.
+   * @param[in] x0 first column. Sample (x, y) is getHeightVector()[x + y * getXSamples()]
+   * @param[in] y0 first row
+   * @param[in] width the number of columns
+   * @param[in] height the number of rows
+   * @param[in] values width * height heights. Sample (i, j) of the rectangle is values[i + j * width]
+   * @param[in] regions records the rectangle and keeps the collision bounds (see HeightMapRegions). If nullptr, the
+   * heightmap is marked as updated (see isUpdated) and the bounds are recomputed from all samples when the new heights
+   * exceed the old heights of the rectangle
+   */
+  void updateRegion(size_t x0, size_t y0, size_t width, size_t height, const double *values,
+                    HeightMapRegions *regions = nullptr) {
+    RSFATAL_IF(x0 + width > xSamples_ || y0 + height > ySamples_, "The region exceeds the heightmap")
+    RSFATAL_IF(regions && regions->heightMap_ && regions->heightMap_ != this, "The regions belong to another heightmap")
+    if (width == 0 || height == 0) return;
+
+    // the collision data is stored upside down
+    double oldMin = std::numeric_limits<double>::infinity(), oldMax = -oldMin, newMin = oldMin, newMax = -oldMin;
+    for (size_t j = 0; j < height; j++) {
+      double *row = &height_[x0 + (y0 + j) * xSamples_], *odeRow = &odeHeight_[x0 + (ySamples_ - 1 - y0 - j) * xSamples_];
+      const double *value = values + j * width;
+      for (size_t i = 0; i < width; i++) {
+        oldMin = std::min(oldMin, row[i]);
+        oldMax = std::max(oldMax, row[i]);
+        newMin = std::min(newMin, value[i]);
+        newMax = std::max(newMax, value[i]);
+        row[i] = odeRow[i] = value[i];
+      }
+    }
+
+    // the bounds only have to contain the heights. The old heights of the rectangle were inside them
+    if (regions) {
+      if (!regions->boundsValid_) {
+        auto bounds = std::minmax_element(height_.begin(), height_.end());
+        regions->minHeight_ = *bounds.first;
+        regions->maxHeight_ = *bounds.second;
+        regions->boundsValid_ = true;
+        dGeomHeightfieldDataSetBounds(heightFieldData_, regions->minHeight_, regions->maxHeight_);
+      } else if (newMin < regions->minHeight_ || newMax > regions->maxHeight_) {
+        regions->minHeight_ = std::min(regions->minHeight_, newMin);
+        regions->maxHeight_ = std::max(regions->maxHeight_, newMax);
+        dGeomHeightfieldDataSetBounds(heightFieldData_, regions->minHeight_, regions->maxHeight_);
+      }
+      regions->heightMap_ = this;
+      regions->add({x0, y0, width, height});
+    } else {
+      if (newMin < oldMin || newMax > oldMax) {
+        auto bounds = std::minmax_element(height_.begin(), height_.end());
+        dGeomHeightfieldDataSetBounds(heightFieldData_, *bounds.first, *bounds.second);
+      }
+      updated_ = true;
+    }
+  }
+
+  /**
+   * Update a rectangle of samples (see updateRegion above)
+   * @param[in] x0 first column
+   * @param[in] y0 first row
+   * @param[in] width the number of columns
+   * @param[in] height the number of rows
+   * @param[in] values width * height heights, row by row
+   * @param[in] regions records the rectangle and keeps the collision bounds
+   */
+  void updateRegion(size_t x0, size_t y0, size_t width, size_t height, const std::vector<double> &values,
+                    HeightMapRegions *regions = nullptr) {
+    RSFATAL_IF(values.size() != width * height, "Expected "<<width * height<<" heights but got "<<values.size())
+    updateRegion(x0, y0, width, height, values.data(), regions);
+  }
+
   void init(size_t xSamples, size_t ysamples, double xSize, double ySize, double centerX, double centerY);
   std::vector<double> &getHeightMap();
   [[nodiscard]] const std::vector<double> &getHeightMap() const;
@@ -106,6 +267,60 @@ class HeightMap final : public SingleBodyObject {
    */
   void getNormal(double x, double y, Vec<3>& normal) const;
 
+  /**
+   * Get heights at many coordinates. The heights are those of getHeight(). The heightmap is only read, so it can be
+   * called from several threads as long as the heightmap is not updated
+   * @param[in] xs x positions
+   * @param[in] ys y positions
+   * @param[out] heights heights
+   * @param[in] n the number of positions
+   */
+  void getHeights(const float* xs, const float* ys, float* heights, size_t n) const {
+    getHeightsImpl(xs, ys, heights, n);
+  }
+
+  /**
+   * Get heights at many coordinates. The heights are those of getHeight(). The heightmap is only read, so it can be
+   * called from several threads as long as the heightmap is not updated
+   * @param[in] xs x positions
+   * @param[in] ys y positions
+   * @param[out] heights heights
+   * @param[in] n the number of positions
+   */
+  void getHeights(const double* xs, const double* ys, double* heights, size_t n) const {
+    getHeightsImpl(xs, ys, heights, n);
+  }
+
+  /**
+   * Get heights on a grid centered at a point and rotated about z (e.g., a robot-centric elevation map)
+   * @param[in] centerX x position of the center of the grid
+   * @param[in] centerY y position of the center of the grid
+   * @param[in] yaw rotation of the grid about z
+   * @param[in] xSamples the number of samples along the x axis of the grid
+   * @param[in] ySamples the number of samples along the y axis of the grid
+   * @param[in] xSpacing distance between the samples along the x axis of the grid
+   * @param[in] ySpacing distance between the samples along the y axis of the grid
+   * @param[out] heights heights. Sample (i, j) is heights[i + j * xSamples]
+   */
+  void getHeightGrid(double centerX, double centerY, double yaw, size_t xSamples, size_t ySamples,
+                     double xSpacing, double ySpacing, float* heights) const {
+    constexpr size_t CHUNK = 256;
+    double xs[CHUNK], ys[CHUNK], chunk[CHUNK];
+    const double c = std::cos(yaw), s = std::sin(yaw);
+    const size_t n = xSamples * ySamples;
+    for (size_t begin = 0; begin < n; begin += CHUNK) {
+      const size_t end = std::min(begin + CHUNK, n);
+      for (size_t k = begin; k < end; k++) {
+        const double x = (double(k % xSamples) - 0.5 * double(xSamples - 1)) * xSpacing;
+        const double y = (double(k / xSamples) - 0.5 * double(ySamples - 1)) * ySpacing;
+        xs[k - begin] = centerX + c * x - s * y;
+        ys[k - begin] = centerY + s * x + c * y;
+      }
+      getHeightsImpl(xs, ys, chunk, end - begin);
+      for (size_t k = begin; k < end; k++) heights[k] = float(chunk[k - begin]);
+    }
+  }
+
   void destroyCollisionBodies(dSpaceID id) final;
 
 
@@ -162,6 +377,11 @@ class HeightMap final : public SingleBodyObject {
    */
   [[nodiscard]] bool isUpdated() const { return updated_; }
 
+  /**
+   * Mark the heights as updated, so that the server sends all of them again
+   */
+  void setUpdatedTrue() { updated_ = true; }
+
   ~HeightMap() final;
 
   void updateCollision() final;
@@ -266,6 +486,73 @@ class HeightMap final : public SingleBodyObject {
   }
 
  private:
+  template<typename T>
+  void getHeightsImpl(const T* xs, const T* ys, T* heights, size_t n) const {
+    size_t i = 0;
+#ifdef RAISIM_HEIGHTMAP_AVX2
+    if (n >= 4 && __builtin_cpu_supports("avx2")) i = getHeightsAvx2(xs, ys, heights, n);
+#endif
+    for (; i < n; i++) heights[i] = T(getHeight(double(xs[i]), double(ys[i])));
+  }
+
+#ifdef RAISIM_HEIGHTMAP_AVX2
+  __attribute__((target("avx2"))) static __m256d load4(const float* v) { return _mm256_cvtps_pd(_mm_loadu_ps(v)); }
+  __attribute__((target("avx2"))) static __m256d load4(const double* v) { return _mm256_loadu_pd(v); }
+  __attribute__((target("avx2"))) static void store4(float* v, __m256d x) { _mm_storeu_ps(v, _mm256_cvtpd_ps(x)); }
+  __attribute__((target("avx2"))) static void store4(double* v, __m256d x) { _mm256_storeu_pd(v, x); }
+
+  // the masked gather does not read an uninitialized source
+  __attribute__((target("avx2"))) static __m256d gather4(const double* base, __m128i index) {
+    return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), base, index, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+  }
+
+  __attribute__((target("avx2"))) static __m128i clamp4(__m128i index, __m128i upper) {
+    return _mm_min_epi32(_mm_max_epi32(index, _mm_setzero_si128()), upper);
+  }
+
+  // the lookup of getHeight on four points at once: the heightfield is flipped along y, its samples are clamped to the
+  // map and its cells are split along u + v = 1. FMA is not used, so that the result equals getHeight()
+  template<typename T>
+  __attribute__((target("avx2"))) size_t getHeightsAvx2(const T* xs, const T* ys, T* heights, size_t n) const {
+    const double dx = sizeX_ / double(xSamples_ - 1), dz = sizeY_ / double(ySamples_ - 1);
+    const __m256d sampleX = _mm256_set1_pd(dx), sampleZ = _mm256_set1_pd(dz);
+    const __m256d invX = _mm256_set1_pd(1. / dx), invZ = _mm256_set1_pd(1. / dz);
+    const __m256d centerX = _mm256_set1_pd(centerX_), centerY = _mm256_set1_pd(centerY_);
+    const __m256d halfX = _mm256_set1_pd(0.5 * sizeX_), halfY = _mm256_set1_pd(0.5 * sizeY_);
+    const __m256d one = _mm256_set1_pd(1.);
+    const __m128i lastX = _mm_set1_epi32(int(xSamples_) - 1), lastZ = _mm_set1_epi32(int(ySamples_) - 1);
+    const __m128i stride = _mm_set1_epi32(int(xSamples_)), next = _mm_set1_epi32(1);
+    const double* h = height_.data();
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      const __m256d fx = _mm256_add_pd(_mm256_sub_pd(load4(xs + i), centerX), halfX);
+      const __m256d fz = _mm256_add_pd(_mm256_sub_pd(centerY, load4(ys + i)), halfY);
+      const __m256d ix = _mm256_floor_pd(_mm256_mul_pd(fx, invX)), iz = _mm256_floor_pd(_mm256_mul_pd(fz, invZ));
+      const __m256d u = _mm256_mul_pd(_mm256_sub_pd(fx, _mm256_mul_pd(ix, sampleX)), invX);
+      const __m256d v = _mm256_mul_pd(_mm256_sub_pd(fz, _mm256_mul_pd(iz, sampleZ)), invZ);
+      const __m256d lower = _mm256_cmp_pd(_mm256_add_pd(u, v), one, _CMP_LE_OQ);
+
+      const __m128i nx = _mm256_cvttpd_epi32(ix), nz = _mm256_cvttpd_epi32(iz);
+      const __m128i x0 = clamp4(nx, lastX), x1 = clamp4(_mm_add_epi32(nx, next), lastX);
+      const __m128i row0 = _mm_mullo_epi32(_mm_sub_epi32(lastZ, clamp4(nz, lastZ)), stride);
+      const __m128i row1 = _mm_mullo_epi32(_mm_sub_epi32(lastZ, clamp4(_mm_add_epi32(nz, next), lastZ)), stride);
+      const __m256d h00 = gather4(h, _mm_add_epi32(row0, x0));
+      const __m256d h10 = gather4(h, _mm_add_epi32(row0, x1));
+      const __m256d h01 = gather4(h, _mm_add_epi32(row1, x0));
+      const __m256d h11 = gather4(h, _mm_add_epi32(row1, x1));
+
+      const __m256d lowerHeight = _mm256_add_pd(_mm256_add_pd(h00, _mm256_mul_pd(_mm256_sub_pd(h10, h00), u)),
+                                                _mm256_mul_pd(_mm256_sub_pd(h01, h00), v));
+      const __m256d upperHeight = _mm256_add_pd(
+          _mm256_add_pd(h11, _mm256_mul_pd(_mm256_sub_pd(h10, h11), _mm256_sub_pd(one, v))),
+          _mm256_mul_pd(_mm256_sub_pd(h01, h11), _mm256_sub_pd(one, u)));
+      store4(heights + i, _mm256_blendv_pd(upperHeight, lowerHeight, lower));
+    }
+    return i;
+  }
+#endif
+
   void generateTerrain(const TerrainProperties &terrainProperties);
   std::vector<double> height_, odeHeight_;
   std::vector<ColorRGB> colorMap_;
@@ -0,0 +1,136 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_OBJECT_TERRAIN_TERRAINCACHE_HPP_
+#define RAISIM_INCLUDE_RAISIM_OBJECT_TERRAIN_TERRAINCACHE_HPP_
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "raisim/World.hpp"
+#include "raisim/helper.hpp"
+
+namespace raisim {
+
+/**
+ * A process-wide cache of decoded terrain heights, so that adding the same heightmap again (e.g., when switching scenes)
+ * does not decode its png file again. A png file is keyed by its path, its modification time, the height scale and the
+ * height offset. A modified file is decoded again. The heights are immutable and shared by all users of an entry.
+ * Each HeightMap keeps its own copy of the heights and its own collision data, because the physics engine owns them. */
+class TerrainCache {
+ public:
+  struct Heights {
+    size_t xSamples, ySamples;
+    std::vector<double> height;
+  };
+
+  /// @return the cache of the process
+  static TerrainCache &get() {
+    static TerrainCache cache;
+    return cache;
+  }
+
+  /**
+   * @param[in] pngFileName the png file
+   * @param[in] heightScale a png file (if 8-bit) has pixel values from 0 to 255. This parameter scales the pixel values to the actual height
+   * @param[in] heightOffset height of the 0-value pixel
+   * @return the decoded heights, as HeightMap reads them from the png file */
+  std::shared_ptr<const Heights> getPng(const std::string &pngFileName, double heightScale, double heightOffset) {
+    std::error_code error;
+    const auto modified = std::filesystem::last_write_time(pngFileName, error);
+    const PngKey key{pngFileName, error ? 0 : modified.time_since_epoch().count(), heightScale, heightOffset};
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto found = png_.find(key);
+    if (found != png_.end()) return found->second;
+
+    // an older version of the file is not needed anymore
+    for (auto it = png_.begin(); it != png_.end();)
+      it = std::get<0>(it->first) == pngFileName ? png_.erase(it) : std::next(it);
+
+    auto heights = std::make_shared<Heights>();
+    int width = 0, height = 0;
+    read_png_file(pngFileName.c_str(), width, height, heights->height, heightScale, heightOffset);
+    RSFATAL_IF(width < 2 || height < 2, "Cannot read the png file " << pngFileName)
+    heights->xSamples = size_t(width);
+    heights->ySamples = size_t(height);
+    png_[key] = heights;
+    return heights;
+  }
+
+  /**
+   * @param[in] xSamples the number of samples along x
+   * @param[in] ySamples the number of samples along y
+   * @param[in] height the height of all samples
+   * @return flat heights */
+  std::shared_ptr<const Heights> getFlat(size_t xSamples, size_t ySamples, double height) {
+    const FlatKey key{xSamples, ySamples, height};
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto &heights = flat_[key];
+    if (!heights) heights = std::make_shared<Heights>(Heights{xSamples, ySamples, std::vector<double>(xSamples * ySamples, height)});
+    return heights;
+  }
+
+  /**
+   * World::addHeightMap() of a png file, with the heights decoded once per process
+   * @param[in] world the world
+   * @param[in] pngFileName the png file which will be used to create the height map
+   * @param[in] centerX x coordinate of the center of the height map
+   * @param[in] centerY y coordinate of the center of the height map
+   * @param[in] xSize x width of the height map
+   * @param[in] ySize y length of the height map
+   * @param[in] heightScale a png file (if 8-bit) has pixel values from 0 to 255. This parameter scales the pixel values to the actual height
+   * @param[in] heightOffset height of the 0-value pixel
+   * @param[in] material material of the height map
+   * @param[in] collisionGroup read "Contact and Collision/ Collision Group and Mask"
+   * @param[in] collisionMask read "Contact and Collision/ Collision Group and Mask"
+   * @return pointer to the created height map */
+  HeightMap *addHeightMap(World &world,
+                          const std::string &pngFileName,
+                          double centerX,
+                          double centerY,
+                          double xSize,
+                          double ySize,
+                          double heightScale,
+                          double heightOffset,
+                          const std::string &material = "default",
+                          CollisionGroup collisionGroup = RAISIM_STATIC_COLLISION_GROUP,
+                          CollisionGroup collisionMask = CollisionGroup(-1)) {
+    auto heights = getPng(pngFileName, heightScale, heightOffset);
+    return world.addHeightMap(heights->xSamples, heights->ySamples, xSize, ySize, centerX, centerY, heights->height,
+                              material, collisionGroup, collisionMask);
+  }
+
+  /// remove all entries. Heights in use stay valid
+  void clear() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    png_.clear();
+    flat_.clear();
+  }
+
+  /// @return the number of entries
+  [[nodiscard]] size_t size() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return png_.size() + flat_.size();
+  }
+
+ private:
+  using PngKey = std::tuple<std::string, int64_t, double, double>;
+  using FlatKey = std::tuple<size_t, size_t, double>;
+
+  TerrainCache() = default;
+
+  std::mutex mutex_;
+  std::map<PngKey, std::shared_ptr<const Heights>> png_;
+  std::map<FlatKey, std::shared_ptr<const Heights>> flat_;
+};
+
+}
+
+#endif // RAISIM_INCLUDE_RAISIM_OBJECT_TERRAIN_TERRAINCACHE_HPP_
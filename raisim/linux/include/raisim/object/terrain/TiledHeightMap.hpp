@@ -0,0 +1,415 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_OBJECT_TERRAIN_TILEDHEIGHTMAP_HPP_
+#define RAISIM_INCLUDE_RAISIM_OBJECT_TERRAIN_TILEDHEIGHTMAP_HPP_
+
+#if defined __linux__ || __APPLE__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define RAISIM_TILED_HEIGHTMAP_MMAP 1
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "raisim/World.hpp"
+
+namespace raisim {
+
+/**
+ * A heightmap too large to be kept in memory. It is stored in a tile file (see write()) that is memory-mapped, so only
+ * the pages that are read are loaded by the operating system. The tiles around given positions (e.g., the robots) are
+ * added to the world as HeightMap objects. The other tiles have no collision bodies. When more than maxResidentTiles
+ * tiles are resident, the least recently used tiles are removed from the world.
+ * A tile has tileCells x tileCells cells. Neighboring tiles share their border samples, so the surface of the resident
+ * tiles is the surface of the whole map. getHeight() and getNormal() read the file and follow HeightMap::getHeight() and
+ * HeightMap::getNormal() of the whole map, also where no tile is resident.
+ * The samples can be stored as float32 or as int16 with a scale and an offset per tile (see Precision), which makes the
+ * file and the pages read by the queries 2 or 4 times smaller. They are decoded when they are read. */
+class TiledHeightMap {
+ public:
+  static constexpr uint64_t MAGIC = 0x3250414d48545352; // "RSTHMAP2"
+  /// the largest number of cells of a tile along x and y
+  static constexpr uint64_t MAX_TILE_CELLS = 1 << 16;
+
+  /// the storage of the samples in the tile file
+  enum class Precision : uint64_t {
+    DOUBLE = 0,
+    FLOAT,
+    /// a tile starts with its scale and offset (doubles). A sample s is the height s * scale + offset. The error is at
+    /// most half a step, i.e., (maximum - minimum) / 131068 of the heights of the tile
+    INT16
+  };
+
+  struct Header {
+    uint64_t magic;
+    uint64_t xSamples, ySamples, tileCells;
+    double xSize, ySize, centerX, centerY;
+    Precision precision;
+  };
+
+  /**
+   * write a tile file without holding the whole map in memory
+   * @param[in] path the tile file
+   * @param[in] xSamples the number of samples along x
+   * @param[in] ySamples the number of samples along y
+   * @param[in] xSize the size of the map along x
+   * @param[in] ySize the size of the map along y
+   * @param[in] centerX x coordinate of the center of the map
+   * @param[in] centerY y coordinate of the center of the map
+   * @param[in] height the height of sample (i, j), i.e., the entry i + j * xSamples of a HeightMap height vector
+   * @param[in] tileCells the number of cells of a tile along x and y
+   * @param[in] precision the storage of the samples
+   * @return true on success */
+  static bool write(const std::string &path, size_t xSamples, size_t ySamples, double xSize, double ySize,
+                    double centerX, double centerY, const std::function<double(size_t, size_t)> &height,
+                    size_t tileCells = 128, Precision precision = Precision::DOUBLE) {
+    RSFATAL_IF(xSamples < 2 || ySamples < 2 || tileCells < 1, "A tiled heightmap needs at least 2 x 2 samples and a tile size")
+    RSFATAL_IF(tileCells > MAX_TILE_CELLS, "A tile can have at most " << MAX_TILE_CELLS << " cells along x and y")
+    Header header{MAGIC, xSamples, ySamples, tileCells, xSize, ySize, centerX, centerY, precision};
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    const size_t stride = tileCells + 1, tilesX = tileCount(xSamples, tileCells), tilesY = tileCount(ySamples, tileCells);
+    std::vector<double> tile(stride * stride);
+    std::vector<char> encoded(tileBytes(stride, precision));
+    for (size_t ty = 0; ty < tilesY; ty++)
+      for (size_t tx = 0; tx < tilesX; tx++) {
+        // the samples beyond the map repeat the first sample of the tile, so that they do not widen the int16 range
+        const size_t columns = std::min(stride, xSamples - tx * tileCells), rows = std::min(stride, ySamples - ty * tileCells);
+        std::fill(tile.begin(), tile.end(), height(tx * tileCells, ty * tileCells));
+        for (size_t j = 0; j < rows; j++)
+          for (size_t i = 0; i < columns; i++)
+            tile[i + j * stride] = height(tx * tileCells + i, ty * tileCells + j);
+        encode(tile, precision, encoded.data());
+        file.write(encoded.data(), std::streamsize(encoded.size()));
+      }
+    return bool(file);
+  }
+
+  /**
+   * write the heights of a heightmap to a tile file
+   * @param[in] path the tile file
+   * @param[in] map the heightmap
+   * @param[in] tileCells the number of cells of a tile along x and y
+   * @param[in] precision the storage of the samples
+   * @return true on success */
+  static bool write(const std::string &path, const HeightMap &map, size_t tileCells = 128,
+                    Precision precision = Precision::DOUBLE) {
+    auto &height = map.getHeightVector();
+    const size_t xSamples = map.getXSamples();
+    return write(path, xSamples, map.getYSamples(), map.getXSize(), map.getYSize(), map.getCenterX(),
+                 map.getCenterY(), [&](size_t i, size_t j) { return height[i + j * xSamples]; }, tileCells, precision);
+  }
+
+  /**
+   * @param[in] world the world to which the resident tiles are added
+   * @param[in] path the tile file written by write()
+   * @param[in] maxResidentTiles the number of resident tiles above which the least recently used tiles are removed
+   * @param[in] material material of the tiles
+   * @param[in] collisionGroup read "Contact and Collision/ Collision Group and Mask"
+   * @param[in] collisionMask read "Contact and Collision/ Collision Group and Mask" */
+  TiledHeightMap(World &world, const std::string &path, size_t maxResidentTiles = 16, std::string material = "default",
+                 CollisionGroup collisionGroup = RAISIM_STATIC_COLLISION_GROUP,
+                 CollisionGroup collisionMask = CollisionGroup(-1))
+      : world_(world), maxResidentTiles_(maxResidentTiles), material_(std::move(material)),
+        collisionGroup_(collisionGroup), collisionMask_(collisionMask) {
+    mapFile(path);
+    RSFATAL_IF(!data_ || size_ < sizeof(Header), "Cannot read the tiled heightmap " << path)
+    std::memcpy(&header_, data_, sizeof(Header));
+    RSFATAL_IF(header_.magic != MAGIC, path << " is not a tiled heightmap")
+    RSFATAL_IF(header_.precision > Precision::INT16, path << " has an unknown precision")
+    RSFATAL_IF(header_.xSamples < 2 || header_.ySamples < 2, path << " has less than 2 x 2 samples")
+    RSFATAL_IF(header_.tileCells < 1 || header_.tileCells > MAX_TILE_CELLS, path << " has an invalid tile size")
+    RSFATAL_IF(!(header_.xSize > 0.) || !(header_.ySize > 0.) || !std::isfinite(header_.xSize) ||
+               !std::isfinite(header_.ySize) || !std::isfinite(header_.centerX) || !std::isfinite(header_.centerY),
+               path << " has an invalid size or center")
+    tilesX_ = tileCount(header_.xSamples, header_.tileCells);
+    tilesY_ = tileCount(header_.ySamples, header_.tileCells);
+    stride_ = header_.tileCells + 1;
+    tileBytes_ = tileBytes(stride_, header_.precision);
+    // tilesX_ * tilesY_ * tileBytes_ can overflow
+    const size_t payload = size_ - sizeof(Header);
+    RSFATAL_IF(tilesX_ > payload / tileBytes_ || tilesY_ > payload / tileBytes_ / tilesX_,
+               "The tiled heightmap " << path << " is truncated")
+    tiles_ = data_ + sizeof(Header);
+    dx_ = header_.xSize / double(header_.xSamples - 1);
+    dy_ = header_.ySize / double(header_.ySamples - 1);
+  }
+
+  TiledHeightMap(const TiledHeightMap &) = delete;
+  TiledHeightMap &operator=(const TiledHeightMap &) = delete;
+
+  /// removes the resident tiles from the world
+  ~TiledHeightMap() {
+    for (auto &tile: resident_) world_.removeObject(tile.second.map);
+    unmapFile();
+  }
+
+  /**
+   * make the tiles within a square of half-width radius around each position resident
+   * @param[in] positions the positions (e.g., of the robots). Only x and y are used
+   * @param[in] radius the half-width of the square
+   * @return the number of tiles added to the world */
+  size_t update(const std::vector<Vec<3>> &positions, double radius) {
+    updateCounter_++;
+    size_t loaded = 0;
+    const double x0 = header_.centerX - 0.5 * header_.xSize, y0 = header_.centerY - 0.5 * header_.ySize;
+    const double tileWidth = dx_ * double(header_.tileCells), tileHeight = dy_ * double(header_.tileCells);
+
+    for (auto &position: positions) {
+      const long txBegin = clampTile(std::floor((position[0] - radius - x0) / tileWidth), tilesX_);
+      const long txEnd = clampTile(std::floor((position[0] + radius - x0) / tileWidth), tilesX_);
+      const long tyBegin = clampTile(std::floor((position[1] - radius - y0) / tileHeight), tilesY_);
+      const long tyEnd = clampTile(std::floor((position[1] + radius - y0) / tileHeight), tilesY_);
+      for (long ty = tyBegin; ty <= tyEnd; ty++)
+        for (long tx = txBegin; tx <= txEnd; tx++) loaded += touch(size_t(tx) + size_t(ty) * tilesX_);
+    }
+
+    // tiles used in this update are not evicted, even if there are more of them than maxResidentTiles
+    while (resident_.size() > maxResidentTiles_) {
+      const size_t tile = lru_.back();
+      auto found = resident_.find(tile);
+      if (found->second.lastUsed == updateCounter_) break;
+      world_.removeObject(found->second.map);
+      resident_.erase(found);
+      lru_.pop_back();
+    }
+    return loaded;
+  }
+
+  /**
+   * Get height at a given coordinate. It equals HeightMap::getHeight of the whole map
+   * @param[in] x x position
+   * @param[in] y y position
+   * @return height */
+  [[nodiscard]] double getHeight(double x, double y) const {
+    Cell cell;
+    locate(x, y, cell);
+    if (cell.lower)
+      return cell.h00 + (cell.h10 - cell.h00) * cell.u + (cell.h01 - cell.h00) * cell.v;
+    return cell.h11 + (cell.h10 - cell.h11) * (1. - cell.v) + (cell.h01 - cell.h11) * (1. - cell.u);
+  }
+
+  /**
+   * Get normal at a given coordinate. It equals HeightMap::getNormal of the whole map
+   * @param[in] x x position
+   * @param[in] y y position
+   * @param[out] normal normal vector */
+  void getNormal(double x, double y, Vec<3> &normal) const {
+    Cell cell;
+    locate(x, y, cell);
+    // the height differences along x and along the flipped y axis of the heightfield. Like HeightMap::getNormal, both
+    // are divided by the x spacing
+    double slopeX, slopeZ;
+    if (cell.lower) {
+      slopeX = (cell.h10 - cell.h00) / dx_;
+      slopeZ = (cell.h01 - cell.h00) / dx_;
+    } else {
+      slopeX = (cell.h11 - cell.h01) / dx_;
+      slopeZ = (cell.h11 - cell.h10) / dx_;
+    }
+    normal = {-slopeX, slopeZ, 1.};
+    normal /= normal.norm();
+  }
+
+  /**
+   * @param[in] tileX the tile index along x
+   * @param[in] tileY the tile index along y
+   * @return the heightmap of the tile or nullptr if it is not resident */
+  [[nodiscard]] HeightMap *getTile(size_t tileX, size_t tileY) const {
+    auto found = resident_.find(tileX + tileY * tilesX_);
+    return found == resident_.end() ? nullptr : found->second.map;
+  }
+
+  [[nodiscard]] size_t getNumberOfResidentTiles() const { return resident_.size(); }
+  [[nodiscard]] size_t getTilesX() const { return tilesX_; }
+  [[nodiscard]] size_t getTilesY() const { return tilesY_; }
+  [[nodiscard]] const Header &getHeader() const { return header_; }
+
+ private:
+  struct Resident {
+    HeightMap *map;
+    std::list<size_t>::iterator lru;
+    uint64_t lastUsed;
+  };
+
+  // the samples of the heightfield cell of a point, following the cell selection of HeightMap::getHeight
+  struct Cell {
+    double h00, h10, h01, h11, u, v;
+    bool lower;
+  };
+
+  static size_t tileCount(size_t samples, size_t tileCells) { return (samples - 2) / tileCells + 1; }
+
+  // the tiles are padded to 8 bytes, so that the doubles stay aligned
+  static size_t tileBytes(size_t stride, Precision precision) {
+    const size_t samples = stride * stride;
+    switch (precision) {
+      case Precision::FLOAT: return (samples * sizeof(float) + 7) / 8 * 8;
+      case Precision::INT16: return 2 * sizeof(double) + (samples * sizeof(int16_t) + 7) / 8 * 8;
+      default: return samples * sizeof(double);
+    }
+  }
+
+  static void encode(const std::vector<double> &tile, Precision precision, char *out) {
+    if (precision == Precision::DOUBLE) {
+      std::memcpy(out, tile.data(), tile.size() * sizeof(double));
+    } else if (precision == Precision::FLOAT) {
+      for (size_t k = 0; k < tile.size(); k++) {
+        const float h = float(tile[k]);
+        std::memcpy(out + k * sizeof(float), &h, sizeof(float));
+      }
+    } else {
+      auto bounds = std::minmax_element(tile.begin(), tile.end());
+      const double offset = 0.5 * (*bounds.first + *bounds.second);
+      const double scale = *bounds.second > *bounds.first ? (*bounds.second - *bounds.first) / 65534. : 1.;
+      std::memcpy(out, &scale, sizeof(double));
+      std::memcpy(out + sizeof(double), &offset, sizeof(double));
+      for (size_t k = 0; k < tile.size(); k++) {
+        const auto s = int16_t(std::lround((tile[k] - offset) / scale));
+        std::memcpy(out + 2 * sizeof(double) + k * sizeof(int16_t), &s, sizeof(int16_t));
+      }
+    }
+  }
+
+  // sample k of a tile
+  [[nodiscard]] double decode(size_t tile, size_t k) const {
+    const char *data = tiles_ + tile * tileBytes_;
+    switch (header_.precision) {
+      case Precision::FLOAT:
+        return double(reinterpret_cast<const float *>(data)[k]);
+      case Precision::INT16: {
+        const auto *scaleOffset = reinterpret_cast<const double *>(data);
+        return double(reinterpret_cast<const int16_t *>(data + 2 * sizeof(double))[k]) * scaleOffset[0] + scaleOffset[1];
+      }
+      default:
+        return reinterpret_cast<const double *>(data)[k];
+    }
+  }
+
+  static long clampTile(double tile, size_t tiles) {
+    return long(std::min(std::max(tile, 0.), double(tiles - 1)));
+  }
+
+  // sample (i, j) of the map. Samples on a tile border are stored in both tiles
+  [[nodiscard]] double sample(size_t i, size_t j) const {
+    const size_t tx = std::min(i / header_.tileCells, tilesX_ - 1), ty = std::min(j / header_.tileCells, tilesY_ - 1);
+    const size_t li = i - tx * header_.tileCells, lj = j - ty * header_.tileCells;
+    return decode(tx + ty * tilesX_, li + lj * stride_);
+  }
+
+  // the heightfield of a HeightMap is flipped along y. Its samples are clamped to the map
+  [[nodiscard]] double fieldSample(long ix, long iz) const {
+    const long xSamples = long(header_.xSamples), ySamples = long(header_.ySamples);
+    ix = std::min(std::max(ix, 0L), xSamples - 1);
+    iz = std::min(std::max(iz, 0L), ySamples - 1);
+    return sample(size_t(ix), size_t(ySamples - 1 - iz));
+  }
+
+  void locate(double x, double y, Cell &cell) const {
+    const double fx = x - header_.centerX + 0.5 * header_.xSize, fz = header_.centerY - y + 0.5 * header_.ySize;
+    const double ix = std::floor(fx * (1. / dx_)), iz = std::floor(fz * (1. / dy_));
+    cell.u = (fx - ix * dx_) * (1. / dx_);
+    cell.v = (fz - iz * dy_) * (1. / dy_);
+    cell.lower = cell.u + cell.v <= 1.;
+    const long nx = long(ix), nz = long(iz);
+    cell.h10 = fieldSample(nx + 1, nz);
+    cell.h01 = fieldSample(nx, nz + 1);
+    if (cell.lower)
+      cell.h00 = fieldSample(nx, nz);
+    else
+      cell.h11 = fieldSample(nx + 1, nz + 1);
+  }
+
+  // make a tile resident and mark it as the most recently used
+  size_t touch(size_t tile) {
+    auto found = resident_.find(tile);
+    if (found != resident_.end()) {
+      lru_.splice(lru_.begin(), lru_, found->second.lru);
+      found->second.lastUsed = updateCounter_;
+      return 0;
+    }
+
+    const size_t tx = tile % tilesX_, ty = tile / tilesX_;
+    const size_t xSamples = std::min(stride_, header_.xSamples - tx * header_.tileCells);
+    const size_t ySamples = std::min(stride_, header_.ySamples - ty * header_.tileCells);
+    // the int16 copies of a border sample differ between the tiles. sample() reads one of them, so that neighboring
+    // tiles and getHeight() agree
+    std::vector<double> height(xSamples * ySamples);
+    for (size_t j = 0; j < ySamples; j++)
+      for (size_t i = 0; i < xSamples; i++)
+        height[i + j * xSamples] = sample(tx * header_.tileCells + i, ty * header_.tileCells + j);
+
+    const double xSize = dx_ * double(xSamples - 1), ySize = dy_ * double(ySamples - 1);
+    const double centerX = header_.centerX - 0.5 * header_.xSize + dx_ * double(tx * header_.tileCells) + 0.5 * xSize;
+    const double centerY = header_.centerY - 0.5 * header_.ySize + dy_ * double(ty * header_.tileCells) + 0.5 * ySize;
+    auto map = world_.addHeightMap(xSamples, ySamples, xSize, ySize, centerX, centerY, height, material_,
+                                   collisionGroup_, collisionMask_);
+    lru_.push_front(tile);
+    resident_[tile] = {map, lru_.begin(), updateCounter_};
+    return 1;
+  }
+
+  void mapFile(const std::string &path) {
+#ifdef RAISIM_TILED_HEIGHTMAP_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat status;
+    if (fstat(fd, &status) == 0 && status.st_size > 0) {
+      size_ = size_t(status.st_size);
+      void *memory = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (memory != MAP_FAILED) data_ = static_cast<const char *>(memory);
+    }
+    close(fd);
+#else
+    // without mmap, the file is read at once
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return;
+    buffer_.resize(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(buffer_.data(), std::streamsize(buffer_.size()));
+    size_ = buffer_.size();
+    data_ = buffer_.data();
+#endif
+  }
+
+  void unmapFile() {
+#ifdef RAISIM_TILED_HEIGHTMAP_MMAP
+    if (data_) munmap(const_cast<char *>(data_), size_);
+#endif
+    data_ = nullptr;
+  }
+
+  World &world_;
+  size_t maxResidentTiles_;
+  std::string material_;
+  CollisionGroup collisionGroup_, collisionMask_;
+
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  std::vector<char> buffer_;
+  Header header_{};
+  const char *tiles_ = nullptr;
+  size_t tilesX_ = 0, tilesY_ = 0, stride_ = 0, tileBytes_ = 0;
+  double dx_ = 0., dy_ = 0.;
+
+  std::unordered_map<size_t, Resident> resident_;
+  std::list<size_t> lru_;
+  uint64_t updateCounter_ = 0;
+};
+
+}
+
+#endif // RAISIM_INCLUDE_RAISIM_OBJECT_TERRAIN_TILEDHEIGHTMAP_HPP_
@@ -9,6 +9,9 @@
 
 namespace raisim {
 
+class RayCaster;
+class ThreadPool;
+
 class DepthCamera final : public Sensor {
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -27,7 +30,7 @@ class DepthCamera final : public Sensor {
     double clipNear, clipFar;
     double hFOV;
 
-    /// noise type - CURRENTLY NOT USED
+    /// noise type. Only used when the image is rendered in raisim (see update(World&, const RayCaster&, ThreadPool*))
     enum class NoiseType : int {
       GAUSSIAN = 0,
       UNIFORM,
@@ -58,6 +61,7 @@ class DepthCamera final : public Sensor {
   void updateRayDirections() {
     depthArray_.resize(prop_.height * prop_.width);
     threeDPoints_.resize(prop_.height * prop_.width);
+    precomputedRayDir_.clear();
     precomputedRayDir_.reserve(prop_.height * prop_.width);
 
     const double hRef = std::tan(prop_.hFOV * 0.5) * 2.;
@@ -119,6 +123,29 @@ class DepthCamera final : public Sensor {
    */
   void update (class World& world) final;
 
+  /**
+   * Render the depth image in raisim by casting a ray through every pixel (e.g., for headless training with
+   * MeasurementSource::RAISIM). Nothing happens if the last measurement is more recent than 1 / update rate. The pose
+   * of the sensor is updated first. The body carrying the camera is not seen.
+   * Defined in raisim/sensors/RayCastSensors.hpp, which has to be included.
+   * @param[in] world the world that the sensor is in
+   * @param[in] caster the ray caster, updated with the current state of the world (see RayCaster::update)
+   * @param[in] pool threads casting the rays. nullptr casts on the calling thread
+   * @return true if the image was rendered */
+  inline bool update (class World& world, const RayCaster& caster, ThreadPool* pool = nullptr);
+
+  /**
+   * Render the depth image from a given pose, regardless of the update rate. The depth is measured along the optical
+   * axis and clamped to [clipNear, clipFar]. Pixels without a hit within clipFar get clipFar. The noise of the
+   * properties is added to the depth
+   * @param[in] caster the ray caster, updated with the current state of the world
+   * @param[in] position the position of the camera in the world frame
+   * @param[in] orientation the orientation of the camera in the world frame
+   * @param[in] pool threads casting the rays. nullptr casts on the calling thread
+   * @param[in] noiseSeed the seed of the noise of this image */
+  inline void render (const RayCaster& caster, const Vec<3>& position, const Mat<3,3>& orientation,
+                      ThreadPool* pool = nullptr, uint64_t noiseSeed = 0);
+
   /**
    * Convert the depth values to 3D coordinates
    * @param[in] depthArray input depth array to convert
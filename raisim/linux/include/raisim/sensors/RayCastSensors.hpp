@@ -0,0 +1,187 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_SENSORS_RAYCASTSENSORS_HPP_
+#define RAISIM_INCLUDE_RAISIM_SENSORS_RAYCASTSENSORS_HPP_
+
+// Sensor measurements rendered by ray casting (see RayCaster). Include it to use DepthCamera::update and
+// SpinningLidar::update with a RayCaster
+
+#include <cmath>
+#include "raisim/World.hpp"
+#include "raisim/RayCaster.hpp"
+#include "raisim/sensors/DepthSensor.hpp"
+#include "raisim/sensors/SpinningLidar.hpp"
+
+namespace raisim {
+
+namespace sensor_noise {
+
+// counter-based random numbers, so that pixels can be processed in any order and on any thread
+inline uint64_t hash(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/// @return a uniform random number in (0, 1)
+inline double uniform(uint64_t seed, uint64_t index) {
+  return (double(hash(seed ^ hash(index)) >> 11) + 0.5) * (1. / 9007199254740992.);
+}
+
+/// @return a standard normal random number (Box-Muller)
+inline double gaussian(uint64_t seed, uint64_t index) {
+  const double u1 = uniform(seed, 2 * index), u2 = uniform(seed, 2 * index + 1);
+  return std::sqrt(-2. * std::log(u1)) * std::cos(2. * M_PI * u2);
+}
+
+/// @return the seed of the measurement at the given time
+inline uint64_t seedFromTime(double time) { return hash(uint64_t(std::llround(time * 1e9))); }
+
+}
+
+inline bool DepthCamera::update(World &world, const RayCaster &caster, ThreadPool *pool) {
+  const double time = world.getWorldTime();
+  if (getUpdateTimeStamp() >= 0. && time < getUpdateTimeStamp() + 1. / getUpdateRate() - 1e-9) return false;
+  if (as_) updatePose();
+  render(caster, pos_, rot_, pool, sensor_noise::seedFromTime(time));
+  setUpdateTimeStamp(time);
+  return true;
+}
+
+inline void DepthCamera::render(const RayCaster &caster, const Vec<3> &position, const Mat<3, 3> &orientation,
+                                ThreadPool *pool, uint64_t noiseSeed) {
+  // per-thread buffers, so that the camera needs no state besides its images
+  thread_local std::vector<double> directions, lengths;
+  thread_local RayHits hits;
+  const size_t pixels = std::min(precomputedRayDir_.size(), depthArray_.size());
+  directions.resize(3 * pixels);
+  lengths.resize(pixels);
+
+  // the precomputed directions have a unit component along the optical axis
+  for (size_t i = 0; i < pixels; i++) {
+    Vec<3> direction;
+    matvecmul(orientation, precomputedRayDir_[i], direction);
+    const double norm = direction.norm();
+    for (size_t a = 0; a < 3; a++) directions[3 * i + a] = direction[a] / norm;
+    lengths[i] = prop_.clipFar * norm;
+  }
+
+  RayBatch rays;
+  rays.size = pixels;
+  rays.origins = position.ptr();
+  rays.sharedOrigin = true;
+  rays.directions = directions.data();
+  rays.lengths = lengths.data();
+  if (as_ && frameId_ < as_->getFrames().size()) {
+    rays.exclude = as_;
+    rays.excludeLocalIdx = as_->getFrameByIdx(frameId_).currentBodyId;
+  }
+  caster.cast(rays, hits, pool);
+
+  using NoiseType = DepthCameraProperties::NoiseType;
+  lockMutex();
+  for (size_t i = 0; i < pixels; i++) {
+    const double norm = lengths[i] / prop_.clipFar;
+    double depth = hits.object[i] ? hits.distance[i] / norm : prop_.clipFar;
+    if (prop_.noiseType == NoiseType::GAUSSIAN)
+      depth += prop_.mean + prop_.std * sensor_noise::gaussian(noiseSeed, i);
+    else if (prop_.noiseType == NoiseType::UNIFORM)
+      depth += prop_.mean + prop_.std * std::sqrt(3.) * (2. * sensor_noise::uniform(noiseSeed, i) - 1.);
+    depth = std::min(std::max(depth, prop_.clipNear), prop_.clipFar);
+    depthArray_[i] = float(depth);
+    for (size_t a = 0; a < 3; a++) threeDPoints_[i][a] = position[a] + directions[3 * i + a] * depth * norm;
+  }
+  unlockMutex();
+}
+
+inline size_t SpinningLidar::update(World &world, const RayCaster &caster, SpinningLidarScanRing &ring, ThreadPool *pool) {
+  if (as_) updatePose();
+  return sweep(world.getWorldTime(), caster, ring, pool);
+}
+
+inline size_t SpinningLidar::sweep(double time, const RayCaster &caster, SpinningLidarScanRing &ring, ThreadPool *pool) {
+  thread_local std::vector<double> origins, directions, cosPitch, sinPitch;
+  thread_local RayHits hits;
+  const double revolution = 2. * M_PI;
+  const long yawSamples = std::max(prop_.yawSamples, 1), pitchSamples = std::max(prop_.pitchSamples, 1);
+  const double yawStep = revolution / double(yawSamples);
+  const double pitchStep = pitchSamples > 1 ? (prop_.pitchMaxAngle - prop_.pitchMinAngle) / double(pitchSamples - 1) : 0.;
+
+  // the columns in (currentYaw_, yawEnd] (or [yawEnd, currentYaw_) for clockwise spinning)
+  const long direction = prop_.spinDirection > 0 ? 1 : -1;
+  const double swept = std::min(std::max(time - std::max(timeStamp_, 0.), 0.) * prop_.spinningRate * revolution, revolution);
+  const double yawBegin = currentYaw_, yawEnd = currentYaw_ + double(direction) * swept;
+  const long first = direction > 0 ? long(std::floor(yawBegin / yawStep)) + 1 : long(std::ceil(yawBegin / yawStep)) - 1;
+  const long last = direction > 0 ? long(std::floor(yawEnd / yawStep)) : long(std::ceil(yawEnd / yawStep));
+  const size_t columns = size_t(std::min(std::max((last - first) * direction + 1, 0L), yawSamples));
+  const size_t beams = columns * size_t(pitchSamples);
+
+  cosPitch.resize(pitchSamples);
+  sinPitch.resize(pitchSamples);
+  for (long p = 0; p < pitchSamples; p++) {
+    cosPitch[p] = std::cos(prop_.pitchMinAngle + double(p) * pitchStep);
+    sinPitch[p] = std::sin(prop_.pitchMinAngle + double(p) * pitchStep);
+  }
+
+  // the beam (cos(pitch) cos(yaw), cos(pitch) sin(yaw), sin(pitch)) starts at rangeMin
+  origins.resize(3 * beams);
+  directions.resize(3 * beams);
+  for (size_t c = 0; c < columns; c++) {
+    const double yaw = double(first + long(c) * direction) * yawStep;
+    const double cosYaw = std::cos(yaw), sinYaw = std::sin(yaw);
+    double horizontal[3], *d = &directions[3 * c * pitchSamples], *o = &origins[3 * c * pitchSamples];
+    for (size_t a = 0; a < 3; a++) horizontal[a] = cosYaw * rot_(a, 0) + sinYaw * rot_(a, 1);
+    for (long p = 0; p < pitchSamples; p++)
+      for (size_t a = 0; a < 3; a++) {
+        d[3 * p + a] = cosPitch[p] * horizontal[a] + sinPitch[p] * rot_(a, 2);
+        o[3 * p + a] = pos_[a] + prop_.rangeMin * d[3 * p + a];
+      }
+  }
+
+  RayBatch rays;
+  rays.size = beams;
+  rays.origins = origins.data();
+  rays.directions = directions.data();
+  rays.length = prop_.rangeMax - prop_.rangeMin;
+  if (as_ && frameId_ < as_->getFrames().size()) {
+    rays.exclude = as_;
+    rays.excludeLocalIdx = as_->getFrameByIdx(frameId_).currentBodyId;
+  }
+  caster.cast(rays, hits, pool);
+
+  // the hit points in the sensor frame
+  ring.reserve(prop_);
+  auto &scan = ring.next();
+  for (size_t c = 0; c < columns; c++) {
+    const double yaw = double(first + long(c) * direction) * yawStep;
+    const double cosYaw = std::cos(yaw), sinYaw = std::sin(yaw);
+    for (long p = 0; p < pitchSamples; p++) {
+      const size_t beam = c * size_t(pitchSamples) + size_t(p);
+      if (!hits.object[beam]) continue;
+      const double range = prop_.rangeMin + hits.distance[beam];
+      scan.points[scan.size++] = {cosPitch[p] * cosYaw * range, cosPitch[p] * sinYaw * range, sinPitch[p] * range};
+    }
+  }
+  scan.beams = beams;
+  scan.timeStamp = time;
+  scan.yawBegin = yawBegin;
+  scan.yawEnd = yawEnd;
+  scan.position = pos_;
+  scan.orientation = rot_;
+
+  lockMutex();
+  currentYaw_ = std::fmod(yawEnd, revolution);
+  if (currentYaw_ < 0.) currentYaw_ += revolution;
+  timeStamp_ = time;
+  setUpdateTimeStamp(time);
+  unlockMutex();
+  return scan.size;
+}
+
+}
+
+#endif // RAISIM_INCLUDE_RAISIM_SENSORS_RAYCASTSENSORS_HPP_
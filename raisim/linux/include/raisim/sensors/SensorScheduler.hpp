@@ -0,0 +1,237 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_SENSORS_SENSORSCHEDULER_HPP_
+#define RAISIM_INCLUDE_RAISIM_SENSORS_SENSORSCHEDULER_HPP_
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "raisim/World.hpp"
+#include "raisim/RayCaster.hpp"
+#include "raisim/ThreadPool.hpp"
+#include "raisim/sensors/RayCastSensors.hpp"
+
+namespace raisim {
+
+/**
+ * Updates sensors when they are due instead of polling every sensor in every step (see
+ * integrate(World&, SensorScheduler&)). The sensors are kept in a min-heap keyed by their next due time
+ * (getUpdateTimeStamp() + 1 / getUpdateRate()), so a step without a due sensor costs a comparison.
+ * Depth cameras and spinning lidars are rendered by ray casting. The ray caster is updated only in the steps in which one
+ * of them is due. Other sensors (e.g., IMUs) need an update function.
+ * If several sensors are due, they are updated on the threads of the pool, one sensor per thread. A single due sensor
+ * uses the pool for its rays. */
+class SensorScheduler {
+ public:
+  using UpdateFunction = std::function<void(World &, Sensor &)>;
+
+  /**
+   * @param[in] pool threads updating the sensors. nullptr updates them on the calling thread */
+  explicit SensorScheduler(ThreadPool *pool = nullptr) : pool_(pool) {}
+
+  /**
+   * add a sensor. The measurement source of depth cameras and spinning lidars is set to RAISIM.
+   * @param[in] sensor the sensor
+   * @param[in] update called when the sensor is due. The update time stamp is set after the call. If empty, depth cameras
+   * and spinning lidars are rendered by ray casting
+   * @param[in] scanRingCapacity the number of scans kept for a spinning lidar (see getScanRing)
+   * @return false if the sensor cannot be updated (no update function and not a ray-cast sensor) */
+  bool add(Sensor *sensor, UpdateFunction update = nullptr, size_t scanRingCapacity = 4) {
+    const auto type = sensor->getType();
+    const bool rayCast = !update && (type == Sensor::Type::DEPTH || type == Sensor::Type::SPINNING_LIDAR);
+    if (!update && !rayCast) return false;
+    remove(sensor);
+
+    // the slot of a removed sensor is reused. Its generation keeps counting, so that its heap entries stay invalid
+    size_t slot = records_.size();
+    if (free_.empty()) {
+      records_.emplace_back();
+    } else {
+      slot = free_.back();
+      free_.pop_back();
+    }
+
+    auto &record = records_[slot];
+    record.sensor = sensor;
+    record.update = std::move(update);
+    record.rayCast = rayCast;
+    if (rayCast) sensor->setMeasurementSource(Sensor::MeasurementSource::RAISIM);
+    if (rayCast && type == Sensor::Type::SPINNING_LIDAR)
+      record.ring = std::make_unique<SpinningLidarScanRing>(scanRingCapacity);
+
+    index_[sensor] = slot;
+    schedule(slot);
+    return true;
+  }
+
+  /**
+   * add the sensors of an articulated system whose measurement source is RAISIM and that can be rendered by ray casting
+   * @param[in] as the articulated system
+   * @return the number of sensors added */
+  size_t add(ArticulatedSystem &as) {
+    size_t added = 0;
+    for (auto sensorSet: as.getSensorSets())
+      for (auto sensor: sensorSet->getSensors())
+        if (sensor->getMeasurementSource() == Sensor::MeasurementSource::RAISIM) added += add(sensor);
+    return added;
+  }
+
+  /**
+   * @param[in] sensor the sensor to be removed */
+  void remove(Sensor *sensor) {
+    auto found = index_.find(sensor);
+    if (found == index_.end()) return;
+    auto &record = records_[found->second];
+    record.sensor = nullptr;
+    record.update = nullptr;
+    record.ring.reset();
+    record.generation++;
+    free_.push_back(found->second);
+    index_.erase(found);
+
+    // drop the invalid entries once they dominate the heap
+    if (heap_.size() > 2 * index_.size() + 16) {
+      heap_.erase(std::remove_if(heap_.begin(), heap_.end(), [this](const Entry &entry) {
+        auto &r = records_[entry.record];
+        return !r.sensor || entry.generation != r.generation;
+      }), heap_.end());
+      std::make_heap(heap_.begin(), heap_.end(), Later());
+    }
+  }
+
+  /**
+   * recompute the due time of a sensor. Call it after changing the update rate or the update time stamp of a sensor
+   * @param[in] sensor the sensor */
+  void reschedule(Sensor *sensor) {
+    auto found = index_.find(sensor);
+    if (found != index_.end()) schedule(found->second);
+  }
+
+  /**
+   * update the due sensors. Called by integrate(World&, SensorScheduler&)
+   * @param[in] world the world of the sensors
+   * @return the number of sensors updated */
+  size_t update(World &world) {
+    const double time = world.getWorldTime();
+    due_.clear();
+    bool rayCast = false;
+
+    while (!heap_.empty() && heap_.front().due <= time + 1e-10) {
+      std::pop_heap(heap_.begin(), heap_.end(), Later());
+      const auto entry = heap_.back();
+      heap_.pop_back();
+      auto &record = records_[entry.record];
+      if (!record.sensor || entry.generation != record.generation) continue;
+      due_.push_back(entry.record);
+      rayCast |= record.rayCast;
+    }
+    if (due_.empty()) return 0;
+
+    if (rayCast) caster_.update(world.getObjList());
+
+    if (due_.size() == 1 || !pool_) {
+      for (auto record: due_) dispatch(world, records_[record], pool_);
+    } else {
+      pool_->parallelFor(due_.size(), [&](size_t i) { dispatch(world, records_[due_[i]], nullptr); });
+    }
+
+    for (auto record: due_) schedule(record);
+    return due_.size();
+  }
+
+  /// @return the time at which the next sensor is due. Infinite if there is no sensor
+  [[nodiscard]] double getNextDueTime() {
+    while (!heap_.empty()) {
+      auto &entry = heap_.front();
+      auto &record = records_[entry.record];
+      if (record.sensor && entry.generation == record.generation) return entry.due;
+      std::pop_heap(heap_.begin(), heap_.end(), Later());
+      heap_.pop_back();
+    }
+    return std::numeric_limits<double>::infinity();
+  }
+
+  /// @return the number of sensors
+  [[nodiscard]] size_t size() const { return index_.size(); }
+
+  /**
+   * @param[in] lidar a spinning lidar added without an update function
+   * @return the scans of the lidar or nullptr */
+  [[nodiscard]] const SpinningLidarScanRing *getScanRing(const SpinningLidar *lidar) const {
+    auto found = index_.find(lidar);
+    return found == index_.end() ? nullptr : records_[found->second].ring.get();
+  }
+
+  /// @return the ray caster used for the depth cameras and the spinning lidars
+  [[nodiscard]] const RayCaster &getRayCaster() const { return caster_; }
+
+ private:
+  struct Record {
+    Sensor *sensor = nullptr;
+    UpdateFunction update;
+    std::unique_ptr<SpinningLidarScanRing> ring;
+    bool rayCast = false;
+    uint64_t generation = 0;
+  };
+
+  struct Entry {
+    double due;
+    size_t record;
+    uint64_t generation;
+  };
+
+  struct Later {
+    bool operator()(const Entry &a, const Entry &b) const { return a.due > b.due; }
+  };
+
+  // a new entry invalidates the previous entry of the sensor
+  void schedule(size_t record) {
+    auto &r = records_[record];
+    const double stamp = r.sensor->getUpdateTimeStamp();
+    const double due = stamp < 0. ? -std::numeric_limits<double>::infinity() : stamp + 1. / r.sensor->getUpdateRate();
+    heap_.push_back({due, record, ++r.generation});
+    std::push_heap(heap_.begin(), heap_.end(), Later());
+  }
+
+  void dispatch(World &world, Record &record, ThreadPool *pool) {
+    auto sensor = record.sensor;
+    if (record.update) {
+      record.update(world, *sensor);
+      sensor->lockMutex();
+      sensor->setUpdateTimeStamp(world.getWorldTime());
+      sensor->unlockMutex();
+    } else if (sensor->getType() == Sensor::Type::DEPTH) {
+      static_cast<DepthCamera *>(sensor)->update(world, caster_, pool);
+    } else {
+      static_cast<SpinningLidar *>(sensor)->update(world, caster_, *record.ring, pool);
+    }
+  }
+
+  ThreadPool *pool_;
+  RayCaster caster_;
+  std::vector<Record> records_;
+  std::vector<size_t> free_;
+  std::vector<Entry> heap_;
+  std::vector<size_t> due_;
+  std::unordered_map<const Sensor *, size_t> index_;
+};
+
+/**
+ * integrate the world and update the sensors that are due.
+ * It is equivalent to "world.integrate(); scheduler.update(world);"
+ * @param[in] world the world
+ * @param[in,out] scheduler the sensors and their due times */
+inline void integrate(World &world, SensorScheduler &scheduler) {
+  world.integrate();
+  scheduler.update(world);
+}
+
+}
+
+#endif // RAISIM_INCLUDE_RAISIM_SENSORS_SENSORSCHEDULER_HPP_
@@ -33,7 +33,7 @@ class Sensor {
   };
 
   enum class MeasurementSource : int {
-    RAISIM = 0, // [NOT IMPLEMENTED YET] raisim automatically updates the measurements according to the simulation time
+    RAISIM = 0, // raisim updates the measurements according to the simulation time (see SensorScheduler)
     VISUALIZER, // visualizer automatically updates the measurements according to the simulation time
     MANUAL // user manually update the measurements whenever needed.
   };
@@ -10,6 +10,10 @@
 
 namespace raisim {
 
+class RayCaster;
+class ThreadPool;
+class SpinningLidarScanRing;
+
 class SpinningLidar : public Sensor {
  public:
   struct SpinningLidarProperties {
@@ -55,6 +59,27 @@ class SpinningLidar : public Sensor {
    */
   void update (class World& world) final;
 
+  /**
+   * update the lidar measurement by casting the beams of the yaw slice swept since the last update with a RayCaster.
+   * The scan is written to the next buffer of the ring instead of getScan(). Unlike update(World&), the columns of the
+   * slice are half-open (a column is not scanned twice) and a slice longer than a revolution is limited to a revolution
+   * @param[in] world the world
+   * @param[in] caster the ray caster, updated with the current state of the world (see RayCaster::update)
+   * @param[in,out] ring the scan buffers
+   * @param[in] pool threads casting the rays. nullptr casts on the calling thread
+   * @return the number of points of the scan */
+  inline size_t update (class World& world, const RayCaster& caster, SpinningLidarScanRing& ring, ThreadPool* pool = nullptr);
+
+  /**
+   * cast the beams of the yaw slice swept until the given time from the current sensor pose. Used by
+   * update(World&, const RayCaster&, SpinningLidarScanRing&, ThreadPool*) after the pose update
+   * @param[in] time the time at the end of the slice
+   * @param[in] caster the ray caster
+   * @param[in,out] ring the scan buffers
+   * @param[in] pool threads casting the rays. nullptr casts on the calling thread
+   * @return the number of points of the scan */
+  inline size_t sweep (double time, const RayCaster& caster, SpinningLidarScanRing& ring, ThreadPool* pool = nullptr);
+
  private:
   double timeStamp_;
   std::vector<raisim::Vec<3>, AlignedAllocator<raisim::Vec<3>, 32>> scan_;
@@ -63,6 +88,70 @@ class SpinningLidar : public Sensor {
   double currentYaw_ = 0;
 };
 
+/**
+ * A ring of scan buffers written by SpinningLidar::update(World&, const RayCaster&, SpinningLidarScanRing&, ThreadPool*).
+ * The buffers are allocated for a full revolution, so updates do not allocate unless the properties grow. A scan stays
+ * valid until its buffer is reused, i.e., for getCapacity() - 1 further updates. */
+class SpinningLidarScanRing {
+ public:
+  struct Scan {
+    /// hit points in the sensor frame. Only the first size entries are valid
+    std::vector<raisim::Vec<3>, AlignedAllocator<raisim::Vec<3>, 32>> points;
+    size_t size = 0;
+    /// the number of beams cast
+    size_t beams = 0;
+    /// the time stamp of the scan and the yaw range swept, in radians
+    double timeStamp = 0., yawBegin = 0., yawEnd = 0.;
+    /// the pose of the sensor frame in the world frame
+    Vec<3> position;
+    Mat<3,3> orientation;
+  };
+
+  /**
+   * @param[in] capacity the number of scans kept */
+  explicit SpinningLidarScanRing(size_t capacity = 4) : scans_(std::max<size_t>(capacity, 1)) {}
+
+  /**
+   * allocate the buffers for the given properties. Called by the lidar update when needed
+   * @param[in] prop the lidar properties */
+  void reserve(const SpinningLidar::SpinningLidarProperties& prop) {
+    // the sweep casts at least one column and one beam per column, even if a sample count is not positive
+    const size_t points = size_t(std::max(prop.yawSamples, 1)) * size_t(std::max(prop.pitchSamples, 1));
+    for (auto& scan: scans_)
+      if (scan.points.size() < points) scan.points.resize(points);
+  }
+
+  /// @return the number of scans kept
+  [[nodiscard]] size_t size() const { return size_; }
+
+  /// @return the number of buffers
+  [[nodiscard]] size_t getCapacity() const { return scans_.size(); }
+
+  /**
+   * @param[in] i index of the scan. 0 is the oldest
+   * @return the scan */
+  [[nodiscard]] const Scan& getScan(size_t i) const {
+    return scans_[(head_ + scans_.size() - size_ + 1 + i) % scans_.size()];
+  }
+
+  /// @return the last scan
+  [[nodiscard]] const Scan& getLatest() const { return scans_[head_]; }
+
+  void clear() { size_ = 0; }
+
+  /// @return the next buffer. Used by the lidar update
+  Scan& next() {
+    head_ = (head_ + 1) % scans_.size();
+    size_ = std::min(size_ + 1, scans_.size());
+    scans_[head_].size = 0;
+    return scans_[head_];
+  }
+
+ private:
+  std::vector<Scan> scans_;
+  size_t head_ = 0, size_ = 0;
+};
+
 }
 
 #endif //RAISIM_INCLUDE_RAISIM_SENSORS_RGBSENSOR_HPP_
@@ -18,6 +18,8 @@ class Chart {
  public:
   virtual char* initialize(char* data) = 0;
   virtual char* serialize(char* data) = 0;
+  virtual size_t getSerializedSize() = 0;
+  virtual size_t getInitializationSize() = 0;
 
   /**
    * locks chart mutex. This can be used if you use raisim in a multi-threaded environment.
@@ -102,6 +104,17 @@ protected:
     return data;
   }
 
+  size_t getSerializedSize() final {
+    std::lock_guard<std::mutex> guard(mtx_);
+    return 2 * sizeof(int32_t) + timeStamp_.size() * sizeof(double) +
+        data_.size() * (sizeof(int32_t) + size_ * sizeof(double));
+  }
+
+  size_t getInitializationSize() final {
+    using namespace server;
+    return byteSize(title_) + byteSize(names_) + byteSize(xAxis_) + byteSize(yAxis_);
+  }
+
   [[nodiscard]] int32_t size() const { return size_; }
 
  private:
@@ -149,6 +162,16 @@ class BarChart : public Chart {
     return set(data, data_);
   }
 
+  size_t getSerializedSize() final {
+    std::lock_guard<std::mutex> guard(mtx_);
+    return sizeof(int32_t) + data_.size() * sizeof(float);
+  }
+
+  size_t getInitializationSize() final {
+    using namespace server;
+    return byteSize(title_) + byteSize(names_);
+  }
+
  private:
   int32_t size_;
   std::mutex mtx_;
@@ -0,0 +1,97 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_SERVER_FRAMECOMPRESSION_HPP_
+#define RAISIM_INCLUDE_RAISIM_SERVER_FRAMECOMPRESSION_HPP_
+
+#include <vector>
+#include <cstring>
+#include "z/zlib.h"
+#include "raisim/raisim_message.hpp"
+
+namespace raisim {
+namespace server {
+
+/**
+ * Compresses the frames of RaisimServer with zlib (deflate).
+ * The stream is reused between the frames so that the compression state is allocated only once.
+ * A frame made of multiple segments is compressed without concatenating them. */
+class FrameCompressor {
+ public:
+  /**
+   * @param[in] level zlib compression level (1: fastest, 9: smallest) */
+  explicit FrameCompressor(int level = 1) : level_(level) {}
+
+  FrameCompressor(const FrameCompressor &) = delete;
+  FrameCompressor &operator=(const FrameCompressor &) = delete;
+
+  ~FrameCompressor() {
+    if (initialized_) deflateEnd(&stream_);
+  }
+
+  /**
+   * @param[in] level zlib compression level (1: fastest, 9: smallest) */
+  void setLevel(int level) {
+    if (level == level_) return;
+    level_ = level;
+    if (initialized_) deflateEnd(&stream_);
+    initialized_ = false;
+  }
+
+  /**
+   * @param[in] segments the data to be compressed (pointer and size) in order
+   * @param[out] out the compressed stream is written after the first 'offset' bytes. The vector is resized accordingly
+   * @param[in] offset the number of bytes in out to be kept (e.g., a header)
+   * @return the size of the compressed stream */
+  size_t compress(const std::vector<std::pair<const char *, size_t>> &segments, std::vector<char> &out, size_t offset) {
+    if (!initialized_) {
+      memset(&stream_, 0, sizeof(stream_));
+      RSFATAL_IF(deflateInit(&stream_, level_) != Z_OK, "zlib initialization failed")
+      initialized_ = true;
+    } else {
+      deflateReset(&stream_);
+    }
+
+    size_t inputSize = 0;
+    for (auto &segment: segments) inputSize += segment.second;
+    out.resize(offset + deflateBound(&stream_, uLong(inputSize)) + segments.size() * 8);
+    stream_.next_out = reinterpret_cast<Bytef *>(out.data() + offset);
+    stream_.avail_out = uInt(out.size() - offset);
+
+    for (size_t i = 0; i < segments.size(); i++) {
+      stream_.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(segments[i].first));
+      stream_.avail_in = uInt(segments[i].second);
+      int flush = i + 1 == segments.size() ? Z_FINISH : Z_NO_FLUSH;
+      int ret = deflate(&stream_, flush);
+      RSFATAL_IF(ret == Z_STREAM_ERROR || stream_.avail_in != 0, "zlib compression failed")
+    }
+
+    if (segments.empty()) deflate(&stream_, Z_FINISH);
+    out.resize(offset + stream_.total_out);
+    return stream_.total_out;
+  }
+
+  /**
+   * @param[in] in the compressed stream
+   * @param[in] inSize the size of the compressed stream
+   * @param[out] out the decompressed data
+   * @param[in] outSize the size of the decompressed data
+   * @return true if the stream was decompressed to exactly outSize bytes */
+  static bool decompress(const char *in, size_t inSize, char *out, size_t outSize) {
+    uLongf size = uLongf(outSize);
+    return uncompress(reinterpret_cast<Bytef *>(out), &size, reinterpret_cast<const Bytef *>(in), uLong(inSize)) == Z_OK &&
+        size == outSize;
+  }
+
+ private:
+  z_stream stream_;
+  int level_;
+  bool initialized_ = false;
+};
+
+}
+}
+
+#endif // RAISIM_INCLUDE_RAISIM_SERVER_FRAMECOMPRESSION_HPP_
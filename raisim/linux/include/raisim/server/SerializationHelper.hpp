@@ -9,8 +9,11 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <algorithm>
+#include <cmath>
 
 #include "raisim/math.hpp"
+#include "raisim/raisim_message.hpp"
 
 namespace raisim {
 namespace server {
@@ -181,6 +184,185 @@ static inline char *getInFloat(char *data, T *arg, Types... args) {
   return getInFloat(getInFloat(data, arg), args...);
 }
 
+/// quantized encoding. The positions are in fixed point relative to an origin
+static inline char *setQuantized(char *data, const Vec<3> &pos, const Vec<3> &origin, double resolution) {
+  for (int i = 0; i < 3; i++)
+    data = set(data, int32_t(std::lround((pos[i] - origin[i]) / resolution)));
+  return data;
+}
+
+static inline char *getQuantized(char *data, Vec<3> *pos, const Vec<3> &origin, double resolution) {
+  int32_t val;
+  for (int i = 0; i < 3; i++) {
+    data = get(data, &val);
+    (*pos)[i] = origin[i] + val * resolution;
+  }
+  return data;
+}
+
+/// smallest-three quaternion compression. The index of the largest component (2 bits) and
+/// the other three components (10 bits each, in [-1/sqrt(2), 1/sqrt(2)]) are packed in 32 bits
+static inline char *setQuantized(char *data, const Vec<4> &quat) {
+  int largest = 0;
+  for (int i = 1; i < 4; i++)
+    if (std::abs(quat[i]) > std::abs(quat[largest])) largest = i;
+
+  // q and -q are the same rotation. The largest component is made positive so that it can be omitted
+  const double sign = quat[largest] < 0. ? -1. : 1.;
+  const double norm = sign / std::sqrt(quat[0] * quat[0] + quat[1] * quat[1] + quat[2] * quat[2] + quat[3] * quat[3]);
+  uint32_t packed = uint32_t(largest);
+  for (int i = 0, shift = 2; i < 4; i++) {
+    if (i == largest) continue;
+    double v = std::min(std::max(quat[i] * norm * M_SQRT2, -1.), 1.);
+    packed |= uint32_t(std::lround((v + 1.) * 0.5 * 1023.)) << shift;
+    shift += 10;
+  }
+  return set(data, packed);
+}
+
+static inline char *getQuantized(char *data, Vec<4> *quat) {
+  uint32_t packed;
+  data = get(data, &packed);
+  const int largest = int(packed & 3u);
+  double sum = 0.;
+  for (int i = 0, shift = 2; i < 4; i++) {
+    if (i == largest) continue;
+    double v = (double((packed >> shift) & 1023u) / 1023. * 2. - 1.) / M_SQRT2;
+    (*quat)[i] = v;
+    sum += v * v;
+    shift += 10;
+  }
+  (*quat)[largest] = std::sqrt(std::max(1. - sum, 0.));
+  return data;
+}
+
+/// heights in 16 bits: [size][offset][scale][uint16 samples], height = offset + scale * sample
+static inline char *setQuantizedHeights(char *data, const std::vector<double> &heights) {
+  double minHeight = heights.empty() ? 0. : *std::min_element(heights.begin(), heights.end());
+  double maxHeight = heights.empty() ? 0. : *std::max_element(heights.begin(), heights.end());
+  const double scale = maxHeight > minHeight ? (maxHeight - minHeight) / 65535. : 1.;
+  const double inverseScale = 1. / scale;
+  data = set(data, int32_t(heights.size()), float(minHeight), float(scale));
+  for (auto h: heights)
+    data = set(data, uint16_t(std::lround((h - minHeight) * inverseScale)));
+  return data;
+}
+
+static inline char *getQuantizedHeights(char *data, std::vector<double> *heights) {
+  int32_t size;
+  float offset, scale;
+  uint16_t sample;
+  data = get(data, &size, &offset, &scale);
+  heights->resize(size);
+  for (auto &h: *heights) {
+    data = get(data, &sample);
+    h = double(offset) + double(scale) * sample;
+  }
+  return data;
+}
+
+/// @return the number of bytes that set() writes for the vector
+template<typename T>
+static inline size_t byteSize(const std::vector<T> &vec) { return sizeof(int32_t) + vec.size() * sizeof(T); }
+
+/// @return the number of bytes that set() writes for the string
+static inline size_t byteSize(const std::string &str) { return sizeof(int32_t) + str.size(); }
+
+/// @return the number of bytes that set() writes for the strings
+static inline size_t byteSize(const std::vector<std::string> &strs) {
+  size_t size = sizeof(int32_t);
+  for (auto &str: strs) size += byteSize(str);
+  return size;
+}
+
+/**
+ * An output buffer made of pooled chunks. The serializer reserves the space that an object needs before writing it:
+ * the byte size of its variable-length fields (strings, arrays) plus at most `headroom` bytes of fixed-size fields.
+ * If the current chunk is too small, the writing continues in the next chunk, so that a frame is never limited
+ * by the size of a single buffer and the written data never moves. The chunks are reused for the next frame.
+ * The segments can be sent with a single sendmsg/writev call without copying them into a contiguous buffer. */
+class SegmentedBuffer {
+ public:
+  /**
+   * @param[in] chunkSize the size of a chunk. Larger reservations get a chunk of their own size
+   * @param[in] headroom the number of bytes that can always be written after a reservation */
+  explicit SegmentedBuffer(size_t chunkSize = 1 << 22, size_t headroom = 1 << 16) :
+      chunkSize_(chunkSize), headroom_(headroom) {}
+
+  /**
+   * discard the content
+   * @return the beginning of the first chunk */
+  char *reset() {
+    segments_.clear();
+    current_ = 0;
+    return open(0);
+  }
+
+  /**
+   * @param[in] data the current write position
+   * @param[in] bytes the number of bytes to be written (excluding the headroom)
+   * @return the write position, which is in a new chunk if the current one does not have enough space */
+  char *reserve(char *data, size_t bytes) {
+    checkBounds(data);
+    auto &chunk = chunks_[current_];
+    if (size_t(chunk.data() + chunk.size() - data) >= bytes + headroom_) return data;
+    if (data != segmentBegin_) segments_.emplace_back(segmentBegin_, size_t(data - segmentBegin_));
+    current_++;
+    return open(bytes + headroom_);
+  }
+
+  /**
+   * @param[in] data the write position after the last byte */
+  void finish(char *data) {
+    checkBounds(data);
+    if (data != segmentBegin_) segments_.emplace_back(segmentBegin_, size_t(data - segmentBegin_));
+  }
+
+  /**
+   * @return the written segments (pointer and size) in order. Valid after finish() */
+  [[nodiscard]] const std::vector<std::pair<const char *, size_t>> &getSegments() const { return segments_; }
+
+  /**
+   * @return the total number of written bytes. Valid after finish() */
+  [[nodiscard]] size_t size() const {
+    size_t size = 0;
+    for (auto &segment: segments_) size += segment.second;
+    return size;
+  }
+
+  /**
+   * @param[in] dst the destination, which must have size() bytes
+   * @return the pointer after the copied data */
+  char *copyTo(char *dst) const {
+    for (auto &segment: segments_) {
+      memcpy(dst, segment.first, segment.second);
+      dst += segment.second;
+    }
+    return dst;
+  }
+
+ private:
+  char *open(size_t minimumSize) {
+    if (current_ == chunks_.size()) chunks_.emplace_back();
+    auto &chunk = chunks_[current_];
+    size_t size = std::max({chunkSize_, minimumSize, headroom_});
+    if (chunk.size() < size) chunk.resize(size);
+    segmentBegin_ = chunk.data();
+    return segmentBegin_;
+  }
+
+  void checkBounds(const char *data) const {
+    auto &chunk = chunks_[current_];
+    RSFATAL_IF(data < chunk.data() || data > chunk.data() + chunk.size(),
+               "The serialized data overran the output buffer. The reserved space was not sufficient")
+  }
+
+  size_t chunkSize_, headroom_, current_ = 0;
+  char *segmentBegin_ = nullptr;
+  std::vector<std::vector<char>> chunks_;
+  std::vector<std::pair<const char *, size_t>> segments_;
+};
+
 }
 }
 
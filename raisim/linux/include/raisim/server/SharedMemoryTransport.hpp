@@ -0,0 +1,259 @@
+//----------------------------//
+// This file is part of RaiSim//
+// Copyright 2022, RaiSim Tech//
+//----------------------------//
+
+#ifndef RAISIM_INCLUDE_RAISIM_SERVER_SHAREDMEMORYTRANSPORT_HPP_
+#define RAISIM_INCLUDE_RAISIM_SERVER_SHAREDMEMORYTRANSPORT_HPP_
+
+#if defined __linux__ || __APPLE__
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "raisim/raisim_message.hpp"
+
+namespace raisim {
+namespace server {
+
+/// the name of the shared memory object of a RaisimServer launched with Transport::SHARED_MEMORY
+inline std::string sharedMemoryName(int port) { return "/raisim_server_" + std::to_string(port); }
+
+/**
+ * The memory layout of the shared-memory frame ring.
+ * The ring has slotCount slots. Frame i (starting from 1) is written into slot i % slotCount.
+ * Each slot is protected by a seqlock: its sequence is odd while the slot is being written. */
+struct SharedMemoryRingLayout {
+  static constexpr uint32_t MAGIC = 0x4d485352; // "RSHM"
+  static constexpr size_t ALIGNMENT = 64;
+
+  struct alignas(ALIGNMENT) Header {
+    uint32_t magic;
+    uint32_t slotCount;
+    uint64_t slotCapacity;
+    std::atomic<uint64_t> latestFrame; // 0 if no frame was published
+    std::atomic<uint32_t> resyncRequests; // incremented by readers that need all objects to be sent again
+  };
+
+  struct alignas(ALIGNMENT) Slot {
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> frameId;
+    std::atomic<uint64_t> size;
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring requires lock-free 64-bit atomics");
+
+  static size_t slotStride(size_t slotCapacity) {
+    return sizeof(Slot) + (slotCapacity + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  }
+
+  static size_t totalSize(uint32_t slotCount, size_t slotCapacity) {
+    return sizeof(Header) + slotCount * slotStride(slotCapacity);
+  }
+};
+
+/**
+ * Publishes frames into a POSIX shared-memory ring. There is a single writer.
+ * The writer never waits for the readers. A slow reader skips frames. */
+class SharedMemoryRingWriter {
+ public:
+  /**
+   * @param[in] name the name of the shared memory object (e.g., sharedMemoryName(port))
+   * @param[in] slotCount the number of frames kept in the ring
+   * @param[in] slotCapacity the maximum size of a frame in bytes
+   * @param[in] permissions the permission bits of the shared memory object. By default, only the owner can read and
+   * write it. A reader needs write access as well, because it requests resynchronization through the ring */
+  SharedMemoryRingWriter(std::string name, uint32_t slotCount, size_t slotCapacity, mode_t permissions = 0600)
+      : name_(std::move(name)) {
+    using Layout = SharedMemoryRingLayout;
+    RSFATAL_IF(slotCount < 2, "The shared memory ring needs at least two slots")
+    size_ = Layout::totalSize(slotCount, slotCapacity);
+
+    // a stale object of a crashed server is replaced. Attached readers keep the old mapping until they reopen
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, permissions);
+    RSFATAL_IF(fd < 0, "shm_open error for " << name_ << ", errno: " << errno)
+    // shm_open applies the umask
+    RSFATAL_IF(fchmod(fd, permissions) < 0, "fchmod error, errno: " << errno)
+    RSFATAL_IF(ftruncate(fd, off_t(size_)) < 0, "ftruncate error, errno: " << errno)
+    memory_ = static_cast<char *>(mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    close(fd);
+    RSFATAL_IF(memory_ == MAP_FAILED, "mmap error, errno: " << errno)
+
+    header_ = new(memory_) Layout::Header;
+    header_->slotCount = slotCount;
+    header_->slotCapacity = slotCapacity;
+    header_->latestFrame.store(0);
+    header_->resyncRequests.store(0);
+    for (uint32_t i = 0; i < slotCount; i++) {
+      auto slot = new(memory_ + sizeof(Layout::Header) + i * Layout::slotStride(slotCapacity)) Layout::Slot;
+      slot->sequence.store(0);
+      slot->frameId.store(0);
+      slot->size.store(0);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    header_->magic = Layout::MAGIC;
+  }
+
+  SharedMemoryRingWriter(const SharedMemoryRingWriter &) = delete;
+  SharedMemoryRingWriter &operator=(const SharedMemoryRingWriter &) = delete;
+
+  ~SharedMemoryRingWriter() {
+    munmap(memory_, size_);
+    shm_unlink(name_.c_str());
+  }
+
+  /**
+   * @param[in] segments the frame (pointer and size of each segment) in order
+   * @return false if the frame is larger than the slot capacity. The frame is not published in this case */
+  bool publish(const std::vector<std::pair<const char *, size_t>> &segments) {
+    using Layout = SharedMemoryRingLayout;
+    size_t size = 0;
+    for (auto &segment: segments) size += segment.second;
+    if (size > header_->slotCapacity) return false;
+
+    uint64_t frameId = ++frameCounter_;
+    auto slot = getSlot(frameId % header_->slotCount);
+    uint64_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    char *data = reinterpret_cast<char *>(slot) + sizeof(Layout::Slot);
+    for (auto &segment: segments) {
+      memcpy(data, segment.first, segment.second);
+      data += segment.second;
+    }
+    slot->frameId.store(frameId, std::memory_order_relaxed);
+    slot->size.store(size, std::memory_order_relaxed);
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    header_->latestFrame.store(frameId, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @return the number of resync requests of the readers so far. A change means that all objects have to be sent again */
+  [[nodiscard]] uint32_t getResyncRequests() const { return header_->resyncRequests.load(std::memory_order_acquire); }
+
+  [[nodiscard]] size_t getSlotCapacity() const { return header_->slotCapacity; }
+
+ private:
+  SharedMemoryRingLayout::Slot *getSlot(uint64_t index) {
+    using Layout = SharedMemoryRingLayout;
+    return reinterpret_cast<Layout::Slot *>(memory_ + sizeof(Layout::Header) + index * Layout::slotStride(header_->slotCapacity));
+  }
+
+  std::string name_;
+  size_t size_;
+  char *memory_;
+  SharedMemoryRingLayout::Header *header_;
+  uint64_t frameCounter_ = 0;
+};
+
+/**
+ * Reads the latest frame from a shared-memory ring. Reading does not need any system call.
+ * The reader maps the ring writable only to send resync requests. */
+class SharedMemoryRingReader {
+ public:
+  SharedMemoryRingReader() = default;
+  SharedMemoryRingReader(const SharedMemoryRingReader &) = delete;
+  SharedMemoryRingReader &operator=(const SharedMemoryRingReader &) = delete;
+
+  ~SharedMemoryRingReader() { detach(); }
+
+  /**
+   * @param[in] name the name of the shared memory object (e.g., sharedMemoryName(port))
+   * @return true if the ring exists and was mapped */
+  bool attach(const std::string &name) {
+    using Layout = SharedMemoryRingLayout;
+    detach();
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) return false;
+
+    struct stat status;
+    if (fstat(fd, &status) < 0 || size_t(status.st_size) < sizeof(Layout::Header)) {
+      close(fd);
+      return false;
+    }
+
+    size_ = size_t(status.st_size);
+    void *memory = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return false;
+    memory_ = static_cast<char *>(memory);
+    header_ = reinterpret_cast<Layout::Header *>(memory_);
+
+    if (header_->magic != Layout::MAGIC || size_ < Layout::totalSize(header_->slotCount, header_->slotCapacity)) {
+      detach();
+      return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    lastFrameId_ = 0;
+    skippedFrames_ = 0;
+    return true;
+  }
+
+  void detach() {
+    if (memory_) munmap(memory_, size_);
+    memory_ = nullptr;
+    header_ = nullptr;
+  }
+
+  [[nodiscard]] bool isAttached() const { return memory_ != nullptr; }
+
+  /**
+   * @param[out] frame the latest frame, if there is a new one
+   * @return the id of the copied frame, or 0 if there is no new frame */
+  uint64_t readLatest(std::vector<char> &frame) {
+    using Layout = SharedMemoryRingLayout;
+
+    for (int attempt = 0; attempt < 16; attempt++) {
+      uint64_t latest = header_->latestFrame.load(std::memory_order_acquire);
+      if (latest == 0 || latest == lastFrameId_) return 0;
+
+      auto slot = reinterpret_cast<Layout::Slot *>(
+          memory_ + sizeof(Layout::Header) + (latest % header_->slotCount) * Layout::slotStride(header_->slotCapacity));
+      uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+      if (sequence & 1u) continue;
+
+      uint64_t frameId = slot->frameId.load(std::memory_order_relaxed);
+      uint64_t size = slot->size.load(std::memory_order_relaxed);
+      if (frameId != latest || size > header_->slotCapacity) continue;
+
+      frame.resize(size);
+      memcpy(frame.data(), reinterpret_cast<char *>(slot) + sizeof(Layout::Slot), size);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot->sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+      if (lastFrameId_ != 0) skippedFrames_ += frameId - lastFrameId_ - 1;
+      lastFrameId_ = frameId;
+      return frameId;
+    }
+    return 0;
+  }
+
+  /**
+   * ask the writer to send all objects again (e.g., after attaching or after skipping frames) */
+  void requestResync() { header_->resyncRequests.fetch_add(1, std::memory_order_release); }
+
+  /**
+   * @return the number of frames published but not read since attaching */
+  [[nodiscard]] uint64_t getSkippedFrames() const { return skippedFrames_; }
+
+ private:
+  char *memory_ = nullptr;
+  size_t size_ = 0;
+  SharedMemoryRingLayout::Header *header_ = nullptr;
+  uint64_t lastFrameId_ = 0, skippedFrames_ = 0;
+};
+
+}
+}
+
+#endif
+
+#endif // RAISIM_INCLUDE_RAISIM_SERVER_SHAREDMEMORYTRANSPORT_HPP_
@@ -0,0 +1,92 @@
+// Compression ratio and added latency of RaisimServer frames carrying the bundled terrain maps.
+// The frame is built the way RaisimServer::update() initializes a heightmap. Only the heightmap is serialized,
+// which is the dominating part of the first frame of a terrain scene.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "raisim/server/SerializationHelper.hpp"
+#include "raisim/server/FrameCompression.hpp"
+#include "raisim/server/Visuals.hpp"
+#include "raisim/Path.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+using namespace raisim;
+
+static std::vector<double> loadHeights(const std::string &file, int &width, int &height) {
+  int channels;
+  stbi_us *pixels = stbi_load_16(file.c_str(), &width, &height, &channels, 1);
+  RSFATAL_IF(!pixels, "Cannot load " << file)
+
+  // the same scale and offset as in maps/mytest.cpp
+  const double scale = 38.0 / (37312 - 32482), offset = -32650 * scale;
+  std::vector<double> heights(size_t(width) * height);
+  for (size_t i = 0; i < heights.size(); i++) heights[i] = pixels[i] * scale + offset;
+  stbi_image_free(pixels);
+  return heights;
+}
+
+static void serializeFrame(server::SegmentedBuffer &buffer, const std::vector<double> &heights, int width, int height) {
+  using namespace server;
+  char *data = buffer.reset();
+  data = set(data, int32_t(0), int32_t(10019), int32_t(0), int32_t(0)); // size, version, state, server requests
+  data = set(data, int32_t(0), 0.0, std::string("hill1"), uint32_t(1), uint32_t(1)); // update type, time, map, config, objects
+  data = set(data, uint32_t(30), false, ObjectType::HEIGHTMAP, false, int32_t(1), std::string("terrain"));
+  data = set(data, Shape::HeightMap);
+  data = setInFloat(data, 0., 0., 504., 504.);
+  data = set(data, int32_t(width), int32_t(height));
+  data = buffer.reserve(data, heights.size() * sizeof(float));
+  data = setInFloat(data, heights);
+  data = set(data, int32_t(0), int32_t(2), int32_t(0)); // empty color map, masking
+  data = set(data, std::string("hidden"), 0.f, 0.f, 0.f, 0.f);
+  data = setInFloat(data, Vec<3>{0., 0., 0.}, Vec<4>{1., 0., 0., 0.});
+  data = set(data, int32_t(0), int32_t(0), int32_t(0), int32_t(0), int32_t(-1), int32_t(0));
+  buffer.finish(data);
+}
+
+int main(int argc, char *argv[]) {
+  auto binaryPath = raisim::Path::setFromArgv(argv[0]);
+  std::string mapDirectory = argc > 1 ? std::string(argv[1])
+                                      : std::string(binaryPath.getDirectory() + "/rsc/raisimUnrealMaps");
+  constexpr int repetitions = 20;
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::left << std::setw(12) << "map" << std::setw(7) << "level" << std::setw(14) << "frame [kB]"
+            << std::setw(18) << "compressed [kB]" << std::setw(8) << "ratio" << std::setw(18) << "compress [ms]"
+            << "decompress [ms]" << std::endl;
+
+  for (auto &map: {"hill1", "lake1", "mountain1"}) {
+    int width, height;
+    auto heights = loadHeights(mapDirectory + "/" + map + ".png", width, height);
+    server::SegmentedBuffer frame;
+    serializeFrame(frame, heights, width, height);
+    std::vector<char> original(frame.size()), compressed, decompressed(frame.size());
+    frame.copyTo(original.data());
+
+    for (int level: {1, 6, 9}) {
+      server::FrameCompressor compressor(level);
+      double compressTime = 0., decompressTime = 0.;
+
+      for (int i = 0; i < repetitions; i++) {
+        auto start = std::chrono::steady_clock::now();
+        compressor.compress(frame.getSegments(), compressed, 0);
+        auto mid = std::chrono::steady_clock::now();
+        bool ok = server::FrameCompressor::decompress(compressed.data(), compressed.size(),
+                                                      decompressed.data(), decompressed.size());
+        auto end = std::chrono::steady_clock::now();
+        RSFATAL_IF(!ok || decompressed != original, "The decompressed frame is different")
+        compressTime += std::chrono::duration<double, std::milli>(mid - start).count();
+        decompressTime += std::chrono::duration<double, std::milli>(end - mid).count();
+      }
+
+      std::cout << std::left << std::setw(12) << map << std::setw(7) << level
+                << std::setw(14) << original.size() / 1024. << std::setw(18) << compressed.size() / 1024.
+                << std::setw(8) << double(original.size()) / compressed.size()
+                << std::setw(18) << compressTime / repetitions << decompressTime / repetitions << std::endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+// Rendering time of a 640x480 depth image in raisim (DepthCamera::render) on a terrain with obstacles and a robot,
+// against the number of threads. The camera must render within 33 ms to run at 30 Hz.
+// usage: depth_camera_benchmark [width] [height]
+
+#include "raisim/World.hpp"
+#include "raisim/sensors/RayCastSensors.hpp"
+#include "raisim/Path.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+using namespace raisim;
+
+int main(int argc, char *argv[]) {
+  auto binaryPath = raisim::Path::setFromArgv(argv[0]);
+  raisim::World::setActivationKey(binaryPath.getDirectory() + "/rsc/activation.raisim");
+  constexpr int frames = 60;
+  constexpr double rate = 30.;
+
+  World world;
+  TerrainProperties terrain;
+  terrain.frequency = 0.2;
+  terrain.zScale = 2.0;
+  terrain.xSize = terrain.ySize = 40.0;
+  terrain.xSamples = terrain.ySamples = 200;
+  terrain.fractalOctaves = 3;
+  terrain.fractalLacunarity = 2.0;
+  terrain.fractalGain = 0.25;
+  auto heightMap = world.addHeightMap(0.0, 0.0, terrain);
+
+  for (int i = 0; i < 20; i++) {
+    const double x = 2. + 0.8 * i, y = -3. + 0.3 * (i % 20);
+    auto box = world.addBox(0.4, 0.4, 0.6, 1.0);
+    box->setPosition(x, y, heightMap->getHeight(x, y) + 0.3);
+    auto sphere = world.addSphere(0.25, 1.0);
+    sphere->setPosition(x, -y, heightMap->getHeight(x, -y) + 0.25);
+  }
+
+  auto robot = world.addArticulatedSystem(binaryPath.getDirectory() + "/rsc/aliengo/aliengo.urdf");
+  Eigen::VectorXd gc(robot->getGeneralizedCoordinateDim());
+  gc << 3, 0, heightMap->getHeight(3, 0) + 0.5, 1, 0, 0, 0, 0.03, 0.4, -0.8, -0.03, 0.4, -0.8, 0.03, -0.4, 0.8, -0.03, -0.4, 0.8;
+  robot->setGeneralizedCoordinate(gc);
+
+  DepthCamera::DepthCameraProperties properties;
+  properties.name = properties.full_name = "depth";
+  properties.width = argc > 1 ? std::stoi(argv[1]) : 640;
+  properties.height = argc > 2 ? std::stoi(argv[2]) : 480;
+  properties.clipNear = 0.1;
+  properties.clipFar = 10.0;
+  properties.hFOV = 1.5;
+  properties.noiseType = DepthCamera::DepthCameraProperties::NoiseType::GAUSSIAN;
+  properties.std = 0.005;
+
+  // looking forward and 20 degrees down
+  Mat<3, 3> orientation;
+  const double pitch = 20. / 180. * M_PI;
+  orientation.e() << std::cos(pitch), 0, std::sin(pitch), 0, 1, 0, -std::sin(pitch), 0, std::cos(pitch);
+  Vec<3> position = {0., 0., heightMap->getHeight(0., 0.) + 1.0};
+  DepthCamera camera(properties, nullptr, Vec<3>{0, 0, 0}, orientation);
+
+  RayCaster caster;
+  auto start = std::chrono::steady_clock::now();
+  caster.update(world.getObjList());
+  const double updateTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << "image: " << properties.width << "x" << properties.height << ", caster update: " << std::fixed
+            << std::setprecision(2) << updateTime * 1e3 << " ms" << std::endl;
+  std::cout << std::left << std::setw(10) << "threads" << std::setw(14) << "ms/image" << std::setw(14) << "images/s"
+            << "30 Hz" << std::endl;
+
+  for (int threads = 1; threads <= int(std::max(std::thread::hardware_concurrency(), 1u)); threads *= 2) {
+    ThreadPool pool(threads);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) camera.render(caster, position, orientation, &pool, uint64_t(i));
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / frames;
+    std::cout << std::left << std::setw(10) << threads << std::setw(14) << elapsed * 1e3 << std::setw(14)
+              << 1. / elapsed << (elapsed < 1. / rate ? "yes" : "no") << std::endl;
+  }
+
+  size_t hits = 0;
+  for (auto depth: camera.getDepthArray()) hits += depth < properties.clipFar;
+  std::cout << "pixels with a hit: " << hits << " / " << camera.getDepthArray().size() << std::endl;
+  return 0;
+}
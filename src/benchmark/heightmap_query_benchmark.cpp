@@ -0,0 +1,79 @@
+// Height queries of HeightMap: getHeight() point by point against the batched getHeights() and getHeightGrid().
+// The batched heights must equal the scalar heights.
+// usage: heightmap_query_benchmark [number of points]
+
+#include "raisim/object/terrain/HeightMap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+using namespace raisim;
+
+template<typename Function>
+static double measure(int repetitions, Function function) {
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repetitions; r++) function();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+int main(int argc, char *argv[]) {
+  const size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+  TerrainProperties terrainProperties;
+  terrainProperties.frequency = 0.2;
+  terrainProperties.zScale = 3.0;
+  terrainProperties.xSize = 50.0;
+  terrainProperties.ySize = 50.0;
+  terrainProperties.xSamples = 504;
+  terrainProperties.ySamples = 504;
+  terrainProperties.fractalOctaves = 3;
+  terrainProperties.fractalLacunarity = 2.0;
+  terrainProperties.fractalGain = 0.25;
+  HeightMap heightMap(0., 0., terrainProperties);
+
+  // foothold candidates, partly outside the map
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<float> uniform(-27.f, 27.f);
+  std::vector<float> xs(n), ys(n), scalar(n), batched(n);
+  for (size_t i = 0; i < n; i++) {
+    xs[i] = uniform(generator);
+    ys[i] = uniform(generator);
+  }
+
+  constexpr int repetitions = 10;
+  const double scalarTime = measure(repetitions, [&] {
+    for (size_t i = 0; i < n; i++) scalar[i] = float(heightMap.getHeight(xs[i], ys[i]));
+  });
+  const double batchedTime = measure(repetitions, [&] { heightMap.getHeights(xs.data(), ys.data(), batched.data(), n); });
+
+  size_t mismatches = 0;
+  for (size_t i = 0; i < n; i++) mismatches += scalar[i] != batched[i];
+
+  // robot-centric elevation maps of 41 x 41 samples
+  constexpr size_t grid = 41, patches = 1000;
+  std::vector<float> patch(grid * grid), reference(grid * grid);
+  const double gridTime = measure(repetitions, [&] {
+    for (size_t p = 0; p < patches; p++)
+      heightMap.getHeightGrid(0.01 * double(p), -0.01 * double(p), 0.1 * double(p), grid, grid, 0.05, 0.05, patch.data());
+  });
+
+  const double yaw = 0.7, c = std::cos(yaw), s = std::sin(yaw);
+  for (size_t j = 0; j < grid; j++)
+    for (size_t i = 0; i < grid; i++) {
+      const double x = (double(i) - 20.) * 0.05, y = (double(j) - 20.) * 0.05;
+      reference[i + j * grid] = float(heightMap.getHeight(1. + c * x - s * y, 2. + s * x + c * y));
+    }
+  heightMap.getHeightGrid(1., 2., yaw, grid, grid, 0.05, 0.05, patch.data());
+  for (size_t i = 0; i < grid * grid; i++) mismatches += reference[i] != patch[i];
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "points                 " << n << std::endl;
+  std::cout << "getHeight              " << scalarTime / double(n) * 1e9 << " ns/point" << std::endl;
+  std::cout << "getHeights             " << batchedTime / double(n) * 1e9 << " ns/point (x"
+            << scalarTime / batchedTime << ")" << std::endl;
+  std::cout << "getHeightGrid 41 x 41  " << gridTime / double(patches) * 1e6 << " us/patch, "
+            << gridTime / double(patches * grid * grid) * 1e9 << " ns/point" << std::endl;
+  std::cout << "mismatches             " << mismatches << std::endl;
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+// Deformable terrain: footprints written with HeightMap::update() (all samples) against HeightMap::updateRegion().
+// Both heightmaps must end with the same heights.
+// usage: heightmap_region_benchmark [number of steps]
+
+#include "raisim/object/terrain/HeightMap.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+using namespace raisim;
+
+int main(int argc, char *argv[]) {
+  const size_t steps = argc > 1 ? std::stoul(argv[1]) : 1000;
+
+  TerrainProperties terrainProperties;
+  terrainProperties.frequency = 0.2;
+  terrainProperties.zScale = 1.0;
+  terrainProperties.xSize = 50.0;
+  terrainProperties.ySize = 50.0;
+  terrainProperties.xSamples = 504;
+  terrainProperties.ySamples = 504;
+  terrainProperties.fractalOctaves = 3;
+  terrainProperties.fractalLacunarity = 2.0;
+  terrainProperties.fractalGain = 0.25;
+  HeightMap full(0., 0., terrainProperties), patched(0., 0., terrainProperties);
+  const size_t xSamples = full.getXSamples(), ySamples = full.getYSamples();
+
+  // four 10 x 10 footprints per step sinking into the sand
+  constexpr size_t FOOT = 10, FEET = 4;
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<size_t> column(0, xSamples - FOOT), row(0, ySamples - FOOT);
+  std::vector<double> heights = full.getHeightVector(), footprint(FOOT * FOOT);
+  HeightMapRegions regions;
+  double fullTime = 0., regionTime = 0.;
+  size_t regionSamples = 0;
+
+  for (size_t step = 0; step < steps; step++) {
+    for (size_t foot = 0; foot < FEET; foot++) {
+      const size_t x0 = column(generator), y0 = row(generator);
+      for (size_t j = 0; j < FOOT; j++)
+        for (size_t i = 0; i < FOOT; i++) {
+          heights[x0 + i + (y0 + j) * xSamples] -= 0.01;
+          footprint[i + j * FOOT] = heights[x0 + i + (y0 + j) * xSamples];
+        }
+
+      auto start = std::chrono::steady_clock::now();
+      patched.updateRegion(x0, y0, FOOT, FOOT, footprint, &regions);
+      regionTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    full.update(0., 0., full.getXSize(), full.getYSize(), heights);
+    fullTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // what the server would send in this step
+    regionSamples += regions.getNumberOfSamples();
+    regions.clear();
+  }
+
+  size_t mismatches = full.getHeightVector() != patched.getHeightVector();
+  std::mt19937 queries(2);
+  std::uniform_real_distribution<double> uniform(-25., 25.);
+  for (size_t i = 0; i < 100000; i++) {
+    const double x = uniform(queries), y = uniform(queries);
+    mismatches += full.getHeight(x, y) != patched.getHeight(x, y);
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "steps                 " << steps << " (" << FEET << " footprints of " << FOOT << " x " << FOOT << ")" << std::endl;
+  std::cout << "update                " << fullTime / double(steps) * 1e6 << " us/step, "
+            << xSamples * ySamples * sizeof(float) / 1024. << " KiB sent" << std::endl;
+  std::cout << "updateRegion          " << regionTime / double(steps) * 1e6 << " us/step, "
+            << double(regionSamples) / double(steps) * sizeof(float) / 1024. << " KiB sent (x"
+            << fullTime / regionTime << ")" << std::endl;
+  std::cout << "mismatches            " << mismatches << std::endl;
+  return mismatches == 0 ? 0 : 1;
+}
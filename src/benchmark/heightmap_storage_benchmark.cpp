@@ -0,0 +1,84 @@
+// Storage precision of TiledHeightMap: the same terrain written with doubles, floats and int16 samples.
+// Reports the file size, the cost of getHeight() and the error against the double heightmap. The resident tiles must
+// follow getHeight() of the tile file.
+// usage: heightmap_storage_benchmark [number of points]
+
+#include "raisim/World.hpp"
+#include "raisim/object/terrain/TiledHeightMap.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+using namespace raisim;
+
+int main(int argc, char *argv[]) {
+  const size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+  TerrainProperties terrainProperties;
+  terrainProperties.frequency = 0.2;
+  terrainProperties.zScale = 3.0;
+  terrainProperties.xSize = 100.0;
+  terrainProperties.ySize = 100.0;
+  terrainProperties.xSamples = 1001;
+  terrainProperties.ySamples = 1001;
+  terrainProperties.fractalOctaves = 3;
+  terrainProperties.fractalLacunarity = 2.0;
+  terrainProperties.fractalGain = 0.25;
+  HeightMap reference(0., 0., terrainProperties);
+
+  std::mt19937 generator(1);
+  std::uniform_real_distribution<double> uniform(-50., 50.);
+  std::vector<double> xs(n), ys(n), heights(n);
+  for (size_t i = 0; i < n; i++) {
+    xs[i] = uniform(generator);
+    ys[i] = uniform(generator);
+  }
+
+  using Precision = TiledHeightMap::Precision;
+  const std::pair<Precision, const char *> precisions[] = {
+      {Precision::DOUBLE, "double"}, {Precision::FLOAT, "float"}, {Precision::INT16, "int16"}};
+  size_t mismatches = 0;
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "points    " << n << std::endl;
+
+  for (auto &precision: precisions) {
+    const std::string path = std::string("heightmap_storage_benchmark_") + precision.second + ".bin";
+    TiledHeightMap::write(path, reference, 128, precision.first);
+
+    World world;
+    TiledHeightMap tiled(world, path, 4);
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    const double megabytes = double(file.tellg()) / (1024. * 1024.);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++) heights[i] = tiled.getHeight(xs[i], ys[i]);
+    const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double maxError = 0.;
+    for (size_t i = 0; i < n; i++) maxError = std::max(maxError, std::abs(heights[i] - reference.getHeight(xs[i], ys[i])));
+
+    // the heightmap of a resident tile is built from the decoded samples
+    tiled.update({{10., -20., 0.}}, 1.);
+    for (size_t ty = 0; ty < tiled.getTilesY(); ty++)
+      for (size_t tx = 0; tx < tiled.getTilesX(); tx++) {
+        auto tile = tiled.getTile(tx, ty);
+        if (!tile) continue;
+        std::uniform_real_distribution<double> inX(tile->getCenterX() - 0.5 * tile->getXSize(), tile->getCenterX() + 0.5 * tile->getXSize());
+        std::uniform_real_distribution<double> inY(tile->getCenterY() - 0.5 * tile->getYSize(), tile->getCenterY() + 0.5 * tile->getYSize());
+        for (size_t i = 0; i < 10000; i++) {
+          const double x = inX(generator), y = inY(generator);
+          mismatches += std::abs(tile->getHeight(x, y) - tiled.getHeight(x, y)) > 1e-9;
+        }
+      }
+
+    std::cout << std::setw(10) << std::left << precision.second << megabytes << " MiB, "
+              << time / double(n) * 1e9 << " ns/point, max error " << std::scientific << maxError << std::fixed
+              << std::endl;
+    std::remove(path.c_str());
+  }
+
+  std::cout << "mismatches " << mismatches << std::endl;
+  return mismatches == 0 ? 0 : 1;
+}
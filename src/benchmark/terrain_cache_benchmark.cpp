@@ -0,0 +1,46 @@
+// Scene switches over the png maps: HeightMap decoding its png file every time against heights from TerrainCache.
+// Both heightmaps must have the same heights.
+// usage: terrain_cache_benchmark [map directory] [number of switches]
+
+#include "raisim/object/terrain/TerrainCache.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+
+using namespace raisim;
+
+int main(int argc, char *argv[]) {
+  auto binaryPath = raisim::Path::setFromArgv(argv[0]);
+  const std::string mapDirectory = argc > 1 ? std::string(argv[1])
+                                            : std::string(binaryPath.getDirectory() + "/rsc/raisimUnrealMaps");
+  const size_t switches = argc > 2 ? std::stoul(argv[2]) : 40;
+  const std::string maps[] = {"hill1", "lake1", "mountain1"};
+  const double heightScale = 38.0 / (37312 - 32482), heightOffset = -32650 * 38.0 / (37312 - 32482);
+
+  double decodeTime = 0., cacheTime = 0.;
+  size_t mismatches = 0;
+  for (size_t s = 0; s < switches; s++) {
+    const std::string file = mapDirectory + "/" + maps[s % 3] + ".png";
+
+    auto start = std::chrono::steady_clock::now();
+    auto decoded = std::make_unique<HeightMap>(0., 0., file, 504., 504., heightScale, heightOffset);
+    decodeTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    auto heights = TerrainCache::get().getPng(file, heightScale, heightOffset);
+    auto cached = std::make_unique<HeightMap>(heights->xSamples, heights->ySamples, 504., 504., 0., 0., heights->height);
+    cacheTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    mismatches += decoded->getHeightVector() != cached->getHeightVector();
+    mismatches += decoded->getHeight(10., -20.) != cached->getHeight(10., -20.);
+  }
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "switches              " << switches << " (" << TerrainCache::get().size() << " cached maps)" << std::endl;
+  std::cout << "decode png            " << decodeTime / double(switches) * 1e3 << " ms/switch" << std::endl;
+  std::cout << "TerrainCache          " << cacheTime / double(switches) * 1e3 << " ms/switch (x"
+            << decodeTime / cacheTime << ")" << std::endl;
+  std::cout << "mismatches            " << mismatches << std::endl;
+  return mismatches == 0 ? 0 : 1;
+}
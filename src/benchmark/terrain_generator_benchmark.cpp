@@ -0,0 +1,71 @@
+// Perlin fractal terrains: TerrainGenerator::generatePerlinFractalTerrain() against the vectorized generator on the
+// calling thread and on a thread pool. The heights must be equal.
+// usage: terrain_generator_benchmark [number of samples along x and y] [number of threads]
+
+#include "raisim/TerrainGeneratorParallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+using namespace raisim;
+
+template<typename Function>
+static double measure(int repetitions, Function function) {
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repetitions; r++) function();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+int main(int argc, char *argv[]) {
+  const size_t samples = argc > 1 ? std::stoul(argv[1]) : 1000;
+  ThreadPool pool(argc > 2 ? std::stoi(argv[2]) : 0);
+
+  // the terrain of a curriculum with and without steps
+  TerrainProperties terrainProperties;
+  terrainProperties.frequency = 0.2;
+  terrainProperties.zScale = 3.0;
+  terrainProperties.xSize = 100.0;
+  terrainProperties.ySize = 100.0;
+  terrainProperties.xSamples = samples;
+  terrainProperties.ySamples = samples;
+  terrainProperties.fractalOctaves = 5;
+  terrainProperties.fractalLacunarity = 2.0;
+  terrainProperties.fractalGain = 0.25;
+  terrainProperties.heightOffset = -1.5;
+
+  constexpr int repetitions = 5;
+  size_t mismatches = 0;
+  double maxError = 0.;
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "samples                " << samples << " x " << samples << ", " << terrainProperties.fractalOctaves
+            << " octaves" << std::endl;
+
+  for (double stepSize: {0., 0.05}) {
+    terrainProperties.stepSize = stepSize;
+    TerrainGenerator reference(terrainProperties), vectorized(terrainProperties), parallel(terrainProperties);
+
+    const double referenceTime = measure(repetitions, [&] { reference.generatePerlinFractalTerrain(); });
+    const double vectorizedTime = measure(repetitions, [&] { generatePerlinFractalTerrain(vectorized); });
+    const double parallelTime = measure(repetitions, [&] { generatePerlinFractalTerrain(parallel, &pool); });
+
+    auto &expected = reference.getHeightMap();
+    for (auto generated: {&vectorized.getHeightMap(), &parallel.getHeightMap()})
+      for (size_t i = 0; i < expected.size(); i++) {
+        mismatches += (*generated)[i] != expected[i];
+        maxError = std::max(maxError, std::abs((*generated)[i] - expected[i]));
+      }
+
+    std::cout << "step size " << stepSize << std::endl;
+    std::cout << "  generatePerlinFractalTerrain  " << referenceTime * 1e3 << " ms" << std::endl;
+    std::cout << "  vectorized                    " << vectorizedTime * 1e3 << " ms (x" << referenceTime / vectorizedTime
+              << ")" << std::endl;
+    std::cout << "  vectorized, " << std::setw(2) << pool.getNumberOfThreads() << " threads       "
+              << parallelTime * 1e3 << " ms (x" << referenceTime / parallelTime << ")" << std::endl;
+  }
+
+  std::cout << "mismatches             " << mismatches << " (max error " << std::scientific << maxError << ")"
+            << std::endl;
+  return mismatches == 0 ? 0 : 1;
+}
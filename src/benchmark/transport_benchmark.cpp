@@ -0,0 +1,130 @@
+// Throughput of the shared-memory transport against the TCP transport of RaisimServer on the same host.
+// TCP: the client requests a frame and the server sends it over the loopback interface, as in RaisimServer::processRequests.
+// Shared memory: the server publishes a frame into the ring once the client has copied the previous one.
+// The handshake is an atomic of this process, which keeps the two transports comparable (every frame is delivered).
+// The frames are synthetic. Only the transport is measured.
+
+#include "raisim/server/SharedMemoryTransport.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+using namespace raisim;
+
+static bool sendAll(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+    if (sent <= 0) return false;
+    data += sent;
+    size -= size_t(sent);
+  }
+  return true;
+}
+
+static bool receiveAll(int fd, char *data, size_t size) {
+  while (size > 0) {
+    ssize_t received = recv(fd, data, size, 0);
+    if (received <= 0) return false;
+    data += received;
+    size -= size_t(received);
+  }
+  return true;
+}
+
+/// @return the number of frames per second received by the client
+static double benchmarkTcp(size_t frameSize, int frames) {
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  socklen_t length = sizeof(address);
+  RSFATAL_IF(bind(listener, (sockaddr *) &address, length) < 0 || listen(listener, 1) < 0, "bind error")
+  getsockname(listener, (sockaddr *) &address, &length);
+
+  std::thread server([&] {
+    int fd = accept(listener, nullptr, nullptr);
+    std::vector<char> frame(frameSize, 1);
+    int request;
+    for (int i = 0; i < frames; i++) {
+      if (!receiveAll(fd, (char *) &request, sizeof(request))) break;
+      memcpy(frame.data(), &i, sizeof(i));
+      if (!sendAll(fd, frame.data(), frame.size())) break;
+    }
+    close(fd);
+  });
+
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  int flag = 1;
+  setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+  RSFATAL_IF(connect(client, (sockaddr *) &address, sizeof(address)) < 0, "connect error")
+  std::vector<char> frame(frameSize);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < frames; i++) {
+    int request = 0;
+    RSFATAL_IF(!sendAll(client, (char *) &request, sizeof(request)) || !receiveAll(client, frame.data(), frameSize),
+               "TCP transfer failed")
+  }
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  server.join();
+  close(client);
+  close(listener);
+  return frames / elapsed;
+}
+
+/// @return the number of frames per second received by the client
+static double benchmarkSharedMemory(size_t frameSize, int frames) {
+  auto name = server::sharedMemoryName(0) + "_benchmark";
+  server::SharedMemoryRingWriter writer(name, 4, frameSize);
+  std::atomic<int> consumed = {0};
+
+  std::thread server([&] {
+    std::vector<char> frame(frameSize, 1);
+    std::vector<std::pair<const char *, size_t>> segments = {{frame.data(), frame.size()}};
+    for (int i = 0; i < frames; i++) {
+      while (consumed.load(std::memory_order_acquire) < i) std::this_thread::yield();
+      writer.publish(segments);
+    }
+  });
+
+  server::SharedMemoryRingReader reader;
+  RSFATAL_IF(!reader.attach(name), "cannot attach to " << name)
+  std::vector<char> frame;
+  int received = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  while (received < frames)
+    if (reader.readLatest(frame))
+      consumed.store(++received, std::memory_order_release);
+    else
+      std::this_thread::yield();
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  server.join();
+  RSFATAL_IF(reader.getSkippedFrames() != 0, "The reader skipped frames")
+  return frames / elapsed;
+}
+
+int main() {
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::left << std::setw(14) << "frame [kB]" << std::setw(16) << "TCP [frames/s]" << std::setw(14)
+            << "TCP [MB/s]" << std::setw(16) << "shm [frames/s]" << "shm [MB/s]" << std::endl;
+
+  for (size_t frameSize: {size_t(4) << 10, size_t(64) << 10, size_t(1) << 20, size_t(8) << 20}) {
+    int frames = int(std::max(size_t(200), (size_t(1) << 30) / frameSize / 4));
+    double tcp = benchmarkTcp(frameSize, frames);
+    double shm = benchmarkSharedMemory(frameSize, frames);
+    std::cout << std::left << std::setw(14) << frameSize / 1024. << std::setw(16) << tcp << std::setw(14)
+              << tcp * frameSize / 1e6 << std::setw(16) << shm << shm * frameSize / 1e6 << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,63 @@
+// Throughput of WorldPool stepping copies of the aliengo set-up of maps/mytest.cpp (on flat ground) against the
+// number of threads. Each step applies the PD targets, integrates every world and gathers the states.
+// usage: world_pool_benchmark [number of worlds]
+
+#include "raisim/WorldPool.hpp"
+#include "raisim/Path.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+using namespace raisim;
+
+int main(int argc, char *argv[]) {
+  auto binaryPath = raisim::Path::setFromArgv(argv[0]);
+  raisim::World::setActivationKey(binaryPath.getDirectory() + "/rsc/activation.raisim");
+  int nWorlds = argc > 1 ? std::stoi(argv[1]) : 256;
+  constexpr int steps = 200;
+
+  auto setUp = [&](World &world, int) {
+    world.setTimeStep(0.005);
+    world.addGround();
+    auto robot = world.addArticulatedSystem(binaryPath.getDirectory() + "/rsc/aliengo/aliengo.urdf");
+    Eigen::VectorXd gc(robot->getGeneralizedCoordinateDim()), gv(robot->getDOF());
+    gc << 0, 0, 0.48, 1, 0, 0, 0, 0.03, 0.4, -0.8, -0.03, 0.4, -0.8, 0.03, -0.4, 0.8, -0.03, -0.4, 0.8;
+    gv.setZero();
+    Eigen::VectorXd pGain(robot->getDOF()), dGain(robot->getDOF());
+    pGain.setZero();
+    dGain.setZero();
+    pGain.tail(12).setConstant(100.0);
+    dGain.tail(12).setConstant(1.0);
+    robot->setGeneralizedCoordinate(gc);
+    robot->setGeneralizedForce(Eigen::VectorXd::Zero(robot->getDOF()));
+    robot->setPdGains(pGain, dGain);
+    robot->setPdTarget(gc, gv);
+    return robot;
+  };
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::left << std::setw(10) << "threads" << std::setw(16) << "steps/s" << "speed-up" << std::endl;
+  double singleThread = 0.;
+
+  for (int threads = 1; threads <= int(std::max(std::thread::hardware_concurrency(), 1u)); threads *= 2) {
+    WorldPool pool(nWorlds, setUp, threads);
+    auto initialGc = pool.getGeneralizedCoordinates();
+    auto initialGv = pool.getGeneralizedVelocities();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < steps; i++) {
+      // a policy would write the actions here and read the observations after the step
+      pool.getPdPositionTargets().rightCols(12) = initialGc.rightCols(12);
+      pool.step();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    pool.setStates(initialGc, initialGv);
+
+    double stepsPerSecond = nWorlds * steps / elapsed;
+    if (threads == 1) singleThread = stepsPerSecond;
+    std::cout << std::left << std::setw(10) << threads << std::setw(16) << stepsPerSecond
+              << stepsPerSecond / singleThread << std::endl;
+  }
+
+  return 0;
+}
@@ -1,5 +1,6 @@
 #include "raisim/RaisimServer.hpp"
 #include "raisim/World.hpp"
+#include "raisim/object/terrain/TerrainCache.hpp"
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -31,8 +32,8 @@ public:
     void createHillScene()
     {
         std::cout << "Creating Hill Scene..." << std::endl;
-        auto heightmap = world_->addHeightMap(binaryPath_.getDirectory() + "\\rsc\\raisimUnrealMaps\\hill1.png",
-                                              0, 0, 504, 504, 38.0 / (37312 - 32482), -32650 * 38.0 / (37312 - 32482), "grass");
+        auto heightmap = raisim::TerrainCache::get().addHeightMap(*world_, binaryPath_.getDirectory() + "\\rsc\\raisimUnrealMaps\\hill1.png",
+                                                                   0, 0, 504, 504, 38.0 / (37312 - 32482), -32650 * 38.0 / (37312 - 32482), "grass");
         currentHeightMap_ = heightmap;
         heightmap->setAppearance("hidden");
         scenes_[0].push_back(heightmap);
@@ -44,8 +45,8 @@ public:
     {
         std::cout << "Creating Lake Scene..." << std::endl;
 
-        auto heightmap = world_->addHeightMap(binaryPath_.getDirectory() + "\\rsc\\raisimUnrealMaps\\lake1.png",
-                                              0, 0, 504, 504, 38.0 / (37312 - 32482), -32650 * 38.0 / (37312 - 32482), "grass");
+        auto heightmap = raisim::TerrainCache::get().addHeightMap(*world_, binaryPath_.getDirectory() + "\\rsc\\raisimUnrealMaps\\lake1.png",
+                                                                   0, 0, 504, 504, 38.0 / (37312 - 32482), -32650 * 38.0 / (37312 - 32482), "grass");
         currentHeightMap_ = heightmap;
         heightmap->setAppearance("hidden");
         scenes_[1].push_back(heightmap);
@@ -57,8 +58,8 @@ public:
     {
         std::cout << "Creating Mountain Scene..." << std::endl;
 
-        auto heightmap = world_->addHeightMap(binaryPath_.getDirectory() + "\\rsc\\raisimUnrealMaps\\mountain1.png",
-                                              0, 0, 504, 504, 38.0 / (37312 - 32482), -32650 * 38.0 / (37312 - 32482), "grass");
+        auto heightmap = raisim::TerrainCache::get().addHeightMap(*world_, binaryPath_.getDirectory() + "\\rsc\\raisimUnrealMaps\\mountain1.png",
+                                                                   0, 0, 504, 504, 38.0 / (37312 - 32482), -32650 * 38.0 / (37312 - 32482), "grass");
         currentHeightMap_ = heightmap;
         heightmap->setAppearance("hidden");
         scenes_[2].push_back(heightmap);
@@ -70,17 +71,9 @@ public:
     {
         std::cout << "Creating Wheat Scene..." << std::endl;
 
-        std::vector<double> groundHeight(504 * 504);
-        for (int x = 0; x < 504; x++)
-        {
-            for (int y = 0; y < 504; y++)
-            {
-                int idx = x * 504 + y;
-                groundHeight[idx] = 0;
-            }
-        }
         // 这里的 504x504 是地形的尺寸
-        auto ground = world_->addHeightMap(504, 504, 504, 504, 0, 0, groundHeight, "sand");
+        auto groundHeight = raisim::TerrainCache::get().getFlat(504, 504, 0.);
+        auto ground = world_->addHeightMap(504, 504, 504, 504, 0, 0, groundHeight->height, "sand");
         // 设置地面外观
         ground->setAppearance("hidden");
         scenes_[3].push_back(ground);
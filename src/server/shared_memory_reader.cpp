@@ -0,0 +1,75 @@
+// A reference reader of the shared-memory transport (RaisimServer::Transport::SHARED_MEMORY).
+// It attaches to the ring of a server on the same host and prints the frame rate, the throughput and the world time.
+// With delta encoding, a reader that skipped frames missed changes and removals. It requests a resync and waits for the
+// next keyframe (RaisimServer::KEYFRAME), which contains all objects. A viewer drops the objects that are not in it.
+// usage: shared_memory_reader [port]
+
+#include "raisim/server/SharedMemoryTransport.hpp"
+#include "raisim/server/SerializationHelper.hpp"
+#include "raisim/RaisimServer.hpp"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+using namespace raisim;
+
+int main(int argc, char *argv[]) {
+  int port = argc > 1 ? std::stoi(argv[1]) : 8080;
+  auto name = server::sharedMemoryName(port);
+  server::SharedMemoryRingReader reader;
+
+  std::cout << "waiting for " << name << std::endl;
+  while (!reader.attach(name))
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // the objects were initialized in frames published before this reader attached
+  reader.requestResync();
+
+  std::vector<char> frame;
+  uint64_t frames = 0, bytes = 0, keyframes = 0, skippedBefore = 0, skippedSeen = 0;
+  bool waitingForKeyframe = false;
+  double worldTime = 0.;
+  auto reportTime = std::chrono::steady_clock::now();
+  std::cout << std::fixed << std::setprecision(2);
+
+  while (true) {
+    if (reader.readLatest(frame)) {
+      frames++;
+      bytes += frame.size();
+
+      // [size][version][state][number of server requests][requests][message type][(quantization)][world time]
+      int32_t size, version, state, nRequests, type;
+      char *data = server::get(frame.data(), &size, &version, &state, &nRequests);
+      if (nRequests == 0) {
+        data = server::get(data, &type);
+        if (type & RaisimServer::QUANTIZED) data += 4 * sizeof(double);
+        server::get(data, &worldTime);
+
+        const bool delta = (type & 0xff) == RaisimServer::UPDATE_DELTA;
+        if (delta && reader.getSkippedFrames() != skippedSeen && !waitingForKeyframe) {
+          reader.requestResync();
+          waitingForKeyframe = true;
+        }
+        if (type & RaisimServer::KEYFRAME) {
+          keyframes++;
+          waitingForKeyframe = false;
+        }
+        skippedSeen = reader.getSkippedFrames();
+      }
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - reportTime).count();
+    if (elapsed > 1.) {
+      std::cout << "frames/s: " << frames / elapsed << ", MB/s: " << bytes / elapsed / 1e6
+                << ", skipped: " << reader.getSkippedFrames() - skippedBefore << ", keyframes: " << keyframes
+                << ", world time: " << worldTime << std::endl;
+      frames = bytes = keyframes = 0;
+      skippedBefore = reader.getSkippedFrames();
+      reportTime = now;
+    }
+  }
+}